@@ -0,0 +1,320 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "bench.hpp"
+
+#include <jsbind.hpp>
+#include <jsbind/shared_memory_extension.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace
+{
+
+struct vec3
+{
+    double x, y, z;
+};
+
+int sink_int = 0;
+double sink_double = 0;
+size_t sink_size = 0;
+std::string short_str = "sixteen chars...";
+std::string long_str(1024, 'x');
+vec3 the_vec3 = { 1, 2, 3 };
+
+void nop() {}
+void int1(int a) { sink_int += a; }
+void int3(int a, int b, int c) { sink_int += a + b + c; }
+void int6(int a, int b, int c, int d, int e, int f) { sink_int += a + b + c + d + e + f; }
+void double3(double a, double b, double c) { sink_double += a + b + c; }
+void str1(const std::string& s) { sink_size += s.size(); }
+void vec3_in(const vec3& v) { sink_double += v.x; }
+int int_out() { return sink_int; }
+double double_out() { return 3.5; }
+std::string short_str_out() { return short_str; }
+std::string long_str_out() { return long_str; }
+vec3 vec3_out() { return the_vec3; }
+
+}
+
+JSBIND_BINDINGS(bench)
+{
+    using namespace jsbind;
+
+    value_object<vec3>("Vec3")
+        .field("x", &vec3::x)
+        .field("y", &vec3::y)
+        .field("z", &vec3::z)
+        ;
+
+    function("benchNop", nop);
+    function("benchInt1", int1);
+    function("benchInt3", int3);
+    function("benchInt6", int6);
+    function("benchDouble3", double3);
+    function("benchStr1", str1);
+    function("benchVec3In", vec3_in);
+    function("benchIntOut", int_out);
+    function("benchDoubleOut", double_out);
+    function("benchShortStrOut", short_str_out);
+    function("benchLongStrOut", long_str_out);
+    function("benchVec3Out", vec3_out);
+}
+
+namespace jsbind
+{
+namespace bench
+{
+
+namespace
+{
+
+using clock = std::chrono::steady_clock;
+
+const int repetitions = 5;
+
+struct result
+{
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+};
+
+std::vector<result> results;
+
+// runs f(iterations) a few times and keeps the fastest run
+template <typename F>
+void measure(std::string name, uint64_t iterations, F f)
+{
+    // warm up, so that the js functions are optimized before they're measured
+    {
+        scope s;
+        f(iterations / 10 + 1);
+    }
+
+    double best = 0;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        scope s;
+        auto start = clock::now();
+        f(iterations);
+        double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+        if (i == 0 || ns < best) best = ns;
+    }
+
+    results.push_back({ std::move(name), iterations, best / double(iterations) });
+}
+
+// measures a js loop with the body in `js`, where `i` is the loop counter
+void measure_js(std::string name, uint64_t iterations, const std::string& setup, const std::string& js)
+{
+    auto src = "(function (n) { " + setup + "; for (var i = 0; i < n; ++i) { " + js + "; } })";
+    persistent loop(local::global("eval")(src));
+
+    measure(std::move(name), iterations, [&loop](uint64_t n) {
+        loop.to_local()(double(n));
+    });
+}
+
+void js_to_cpp()
+{
+    const uint64_t n = 1000000;
+    measure_js("js_to_cpp/baseline", n, "var f = function () {}", "f()");
+    measure_js("js_to_cpp/void()", n, "var f = Module.benchNop", "f()");
+    measure_js("js_to_cpp/void(int)", n, "var f = Module.benchInt1", "f(i)");
+    measure_js("js_to_cpp/void(int,int,int)", n, "var f = Module.benchInt3", "f(i, 1, 2)");
+    measure_js("js_to_cpp/void(int*6)", n, "var f = Module.benchInt6", "f(i, 1, 2, 3, 4, 5)");
+    measure_js("js_to_cpp/void(double,double,double)", n, "var f = Module.benchDouble3", "f(i + 0.5, 1.5, 2.5)");
+    measure_js("js_to_cpp/void(string16)", n, "var f = Module.benchStr1, s = 'sixteen chars...'", "f(s)");
+    measure_js("js_to_cpp/void(string1024)", n / 10, "var f = Module.benchStr1, s = 'x'.repeat(1024)", "f(s)");
+    measure_js("js_to_cpp/void(value_object)", n / 10, "var f = Module.benchVec3In, v = { x: 1, y: 2, z: 3 }", "f(v)");
+    measure_js("js_to_cpp/int()", n, "var f = Module.benchIntOut", "f()");
+    measure_js("js_to_cpp/double()", n, "var f = Module.benchDoubleOut", "f()");
+    measure_js("js_to_cpp/string16()", n, "var f = Module.benchShortStrOut", "f()");
+    measure_js("js_to_cpp/string1024()", n / 10, "var f = Module.benchLongStrOut", "f()");
+    measure_js("js_to_cpp/value_object()", n / 10, "var f = Module.benchVec3Out", "f()");
+}
+
+void cpp_to_js()
+{
+    const uint64_t n = 200000;
+
+    run_script(
+        "benchObj = { f: function (a) { return a; } };"
+        "benchFunc = function (a) { return a; };"
+        , "bench");
+
+    persistent obj(local::global("benchObj"));
+    persistent func(local::global("benchFunc"));
+
+    measure("cpp_to_js/local::call", n, [&obj](uint64_t n) {
+        auto o = obj.to_local();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            scope s;
+            sink_int += o.call<int>("f", int(i));
+        }
+    });
+
+    measure("cpp_to_js/local::operator()", n, [&func](uint64_t n) {
+        auto f = func.to_local();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            scope s;
+            sink_int += f(int(i)).as<int>();
+        }
+    });
+
+    run_script("benchObj = undefined; benchFunc = undefined;", "bench");
+}
+
+template <typename T>
+void round_trip(const char* type_name, uint64_t n, const T& value)
+{
+    measure(std::string("convert/to_js/") + type_name, n, [&value](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            scope s;
+            local l(value);
+            sink_size += sizeof(l);
+        }
+    });
+
+    scope s;
+    persistent p((local(value)));
+    measure(std::string("convert/from_js/") + type_name, n, [&p](uint64_t n) {
+        auto l = p.to_local();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            scope s;
+            auto v = l.as<T>();
+            sink_size += sizeof(v);
+        }
+    });
+}
+
+void conversions()
+{
+    const uint64_t n = 1000000;
+    round_trip("int", n, 42);
+    round_trip("double", n, 3.14);
+    round_trip("string16", n, short_str);
+    round_trip("string1024", n / 10, long_str);
+    round_trip("value_object", n / 10, the_vec3);
+}
+
+void arrays()
+{
+    for (uint32_t size : { 10, 1000, 100000 })
+    {
+        scope s;
+
+        auto src = "(function () { var a = []; for (var i = 0; i < " + std::to_string(size) + "; ++i) a.push(i * 0.5); return a; })()";
+        persistent arr(local::global("eval")(src));
+
+        measure("vecFromJSArray/" + std::to_string(size), 10000000 / size, [&arr](uint64_t n) {
+            auto a = arr.to_local();
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                scope s;
+                sink_size += vecFromJSArray<double>(a).size();
+            }
+        });
+    }
+}
+
+void handles()
+{
+    const uint64_t n = 1000000;
+
+    scope s;
+    auto obj = local::object();
+    measure("persistent/create_destroy", n, [&obj](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            persistent p(obj);
+            p.reset();
+        }
+    });
+
+    for (size_t size : { 16, 65536 })
+    {
+        measure("uint8_array/create/" + std::to_string(size), n / 10, [size](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                scope s;
+                uint8_array a(size);
+                sink_size += a.get_size();
+            }
+        });
+    }
+}
+
+const char* backend_name()
+{
+#if defined(JSBIND_NODE)
+    return "node";
+#elif defined(JSBIND_V8)
+    return "v8";
+#elif defined(JSBIND_JSC)
+    return "jsc";
+#elif defined(JSBIND_EMSCRIPTEN)
+    return "emscripten";
+#elif defined(JSBIND_CEF)
+    return "cef";
+#endif
+}
+
+// a json string, for names with quotes or backslashes
+std::string quoted(const std::string& str)
+{
+    std::string ret = "\"";
+    for (auto c : str)
+    {
+        if (c == '"' || c == '\\') ret += '\\';
+        ret += c;
+    }
+    ret += '"';
+    return ret;
+}
+
+}
+
+void run_benchmarks(std::ostream& out)
+{
+    results.clear();
+
+    js_to_cpp();
+    cpp_to_js();
+    conversions();
+    arrays();
+    handles();
+
+    out << "{\n";
+    out << "  \"backend\": " << quoted(backend_name()) << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& r = results[i];
+        out << "    { \"name\": " << quoted(r.name) << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"ops_per_sec\": " << (r.ns_per_op > 0 ? 1e9 / r.ns_per_op : 0) << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}
+}
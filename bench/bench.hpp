@@ -0,0 +1,23 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <iosfwd>
+
+namespace jsbind
+{
+namespace bench
+{
+
+// runs all benchmarks in the current context and writes the results as json
+// must be called after jsbind is initialized
+void run_benchmarks(std::ostream& out);
+
+}
+}
@@ -0,0 +1,37 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include <jsbind/funcs.hpp>
+
+#include "bench.hpp"
+
+#include <iostream>
+#include <fstream>
+
+// usage: jsbind-bench [results.json]
+// the results are written to stdout if no file is given
+int main(int argc, char* argv[])
+{
+    jsbind::initialize();
+    jsbind::enter_context();
+
+    if (argc > 1)
+    {
+        std::ofstream fout(argv[1]);
+        jsbind::bench::run_benchmarks(fout);
+    }
+    else
+    {
+        jsbind::bench::run_benchmarks(std::cout);
+    }
+
+    jsbind::exit_context();
+    jsbind::deinitialize();
+
+    return 0;
+}
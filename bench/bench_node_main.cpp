@@ -0,0 +1,52 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include <jsbind.hpp>
+
+#include "bench.hpp"
+
+#include <iostream>
+#include <fstream>
+
+#if !defined(JSBIND_NODE)
+#   error "This file is for the jsbind node.js bindings"
+#endif
+
+using node::AtExit;
+
+// the results are written to stdout if the path is empty
+void jsbind_run_benchmarks_node(std::string path)
+{
+    if (path.empty())
+    {
+        jsbind::bench::run_benchmarks(std::cout);
+    }
+    else
+    {
+        std::ofstream fout(path);
+        jsbind::bench::run_benchmarks(fout);
+    }
+}
+
+void at_exit(void*)
+{
+    jsbind::deinitialize();
+}
+
+JSBIND_BINDINGS(Benchmarks)
+{
+    jsbind::function("run", jsbind_run_benchmarks_node);
+    AtExit(at_exit);
+}
+
+void node_main(v8::Local<v8::Object> exports)
+{
+    jsbind::v8_initialize_with_global(exports);
+}
+
+NODE_MODULE(bench, node_main)
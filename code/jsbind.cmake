@@ -23,6 +23,11 @@ src_group(jsbind sources
     ${code}/jsbind/common/function_traits.hpp
     ${code}/jsbind/common/wrapped_class.hpp
     ${code}/jsbind/common/ptr_cast.hpp
+    ${code}/jsbind/common/typed_array_traits.hpp
+    ${code}/jsbind/common/field_layout.hpp
+    ${code}/jsbind/common/histogram.hpp
+    ${code}/jsbind/common/mpsc_queue.hpp
+    ${code}/jsbind/common/ticket_lock.hpp
     ${code}/jsbind/common/deinitializers.cpp
     ${code}/jsbind/common/deinitializers.hpp
     ${code}/jsbind/funcs.hpp
@@ -32,19 +37,46 @@ src_group(jsbind sources
     ${code}/jsbind/error.hpp
     ${code}/jsbind/console.cpp
     ${code}/jsbind/console.hpp
+    ${code}/jsbind/async_console.cpp
+    ${code}/jsbind/async_console.hpp
     ${code}/jsbind/exception.cpp
     ${code}/jsbind/exception.hpp
+    ${code}/jsbind/exception_throttle.cpp
+    ${code}/jsbind/exception_throttle.hpp
+    ${code}/jsbind/watchdog.cpp
+    ${code}/jsbind/watchdog.hpp
+    ${code}/jsbind/post.cpp
+    ${code}/jsbind/post.hpp
+    ${code}/jsbind/gc.cpp
+    ${code}/jsbind/gc.hpp
+    ${code}/jsbind/context_lock.cpp
+    ${code}/jsbind/context_lock.hpp
+    ${code}/jsbind/binding_stats.cpp
+    ${code}/jsbind/binding_stats.hpp
+    ${code}/jsbind/profiler.cpp
+    ${code}/jsbind/profiler.hpp
+    ${code}/jsbind/heap_snapshot.cpp
+    ${code}/jsbind/heap_snapshot.hpp
 )
 
 if((NOT JSBIND_JSC) OR (NOT JSBIND_JSC_NO_TYPED_ARRAYS))
     src_group(jsbind sources
         ${code}/jsbind/shared_memory_extension.hpp
+        ${code}/jsbind/mapped_array_buffer.hpp
+        ${code}/jsbind/mapped_array_buffer.cpp
+        ${code}/jsbind/struct_array.hpp
+        ${code}/jsbind/packed_array.hpp
+        ${code}/jsbind/serialization.hpp
+        ${code}/jsbind/serialization.cpp
+        ${code}/jsbind/shared_ring.hpp
+        ${code}/jsbind/shared_ring.cpp
     )
 endif()
 
 if(JSBIND_JSC)
     src_group(jsc sources
         ${code}/jsbind/jsc/jsbind.cpp
+        ${code}/jsbind/context.hpp
         ${code}/jsbind/jsc/value.hpp
         ${code}/jsbind/jsc/global.hpp
         ${code}/jsbind/jsc/convert.hpp
@@ -74,6 +106,9 @@ elseif(JSBIND_CEF)
         ${code}/jsbind/cef/convert.hpp
         ${code}/jsbind/cef/call.hpp
         ${code}/jsbind/cef/bind.hpp
+        ${code}/jsbind/cef/codec.hpp
+        ${code}/jsbind/cef_bridge.hpp
+        ${code}/jsbind/cef_bridge.cpp
     )
 else()
     message(FATAL_ERROR "JSBind: Unsupported jsbind js engine")
@@ -97,6 +132,10 @@ if(JSBIND_DEBUGGING)
     set(defs ${defs} -DJSBIND_DEBUGGING)
 endif()
 
+if(JSBIND_BINDING_STATS)
+    set(defs ${defs} -DJSBIND_BINDING_STATS)
+endif()
+
 if(JSBIND_NODE)
     set(defs ${defs} -DJSBIND_V8 -DJSBIND_NODE -DBUILDING_NODE_EXTENSION)
 elseif(JSBIND_V8)
@@ -118,6 +157,13 @@ target_compile_definitions(${JSBIND_TARGET_NAME} PUBLIC
     ${defs}
 )
 
+if(NOT JSBIND_EMSCRIPTEN)
+    find_package(Threads REQUIRED)
+    target_link_libraries(${JSBIND_TARGET_NAME} PUBLIC
+        Threads::Threads
+    )
+endif()
+
 if(JSBIND_JS_BACKEND_LIBS)
     target_link_libraries(${JSBIND_TARGET_NAME} PUBLIC
         ${JSBIND_JS_BACKEND_LIBS}
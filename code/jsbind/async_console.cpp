@@ -0,0 +1,139 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "async_console.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include <chrono>
+#include <cassert>
+
+namespace jsbind
+{
+
+async_console::async_console(console* target, size_t capacity)
+    : m_target(target)
+    , m_queue(capacity)
+    , m_pushed(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_stop(false)
+    , m_sleeping(false)
+{
+    assert(target && target != this);
+    m_thread = std::thread(&async_console::run, this);
+}
+
+async_console::~async_console()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool async_console::is_enabled(msg_type type) const
+{
+    return m_target->is_enabled(type);
+}
+
+void async_console::msg(msg_type type, const char* msg)
+{
+    // asserts go through the ring too, so that the target is only ever called from the background thread
+    // they aren't dropped, but wait for room and then until they're written
+    std::atomic<bool> written(false);
+    std::atomic<bool>* done = type == msg_assert ? &written : nullptr;
+
+    for (;;)
+    {
+        bool pushed = m_queue.try_push([type, msg, done](entry& e) {
+            e.type = type;
+            e.text.assign(msg); // reuses the memory of older messages in the slot
+            e.done = done;
+        });
+
+        if (pushed) break;
+
+        if (!done)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        wake();
+        std::this_thread::yield();
+    }
+
+    m_pushed.fetch_add(1, std::memory_order_release);
+
+    if (done)
+    {
+        while (!written.load(std::memory_order_acquire))
+        {
+            wake();
+            std::this_thread::yield();
+        }
+    }
+    else if (m_sleeping.load(std::memory_order_acquire))
+    {
+        wake();
+    }
+}
+
+void async_console::wake()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wake.notify_one();
+}
+
+void async_console::flush()
+{
+    auto target = m_pushed.load(std::memory_order_acquire);
+    while (m_written.load(std::memory_order_acquire) < target)
+    {
+        wake();
+        std::this_thread::yield();
+    }
+}
+
+void async_console::drain()
+{
+    while (m_queue.try_pop([this](entry& e) {
+        m_target->msg(e.type, e.text.c_str());
+        if (e.done) e.done->store(true, std::memory_order_release);
+    }))
+    {
+        m_written.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void async_console::run()
+{
+    for (;;)
+    {
+        drain();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stop) break;
+
+        // a producer which missed the flag is picked up on the next timeout
+        m_sleeping.store(true, std::memory_order_release);
+        m_wake.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+            return m_stop || !m_queue.empty();
+        });
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    drain();
+}
+
+}
+
+#endif
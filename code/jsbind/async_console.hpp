@@ -0,0 +1,80 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "console.hpp"
+#include "common/mpsc_queue.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace jsbind
+{
+
+/// Console which passes messages to another console on a background thread,
+/// so that logging from js never waits for I/O.
+///
+///     static jsbind::async_console con(jsbind::get_console());
+///     jsbind::set_console(&con);
+///
+/// The messages are copied into a ring of `capacity` reused buffers. When the ring
+/// is full new messages are dropped (and counted) instead of blocking the caller.
+/// Asserts are never dropped and the caller waits until they're written, after the
+/// messages before them. The target console is only called from the background thread.
+class async_console : public console
+{
+public:
+    explicit async_console(console* target, size_t capacity = 1024);
+    ~async_console();
+
+    virtual bool is_enabled(msg_type type) const override;
+    virtual void msg(msg_type type, const char* msg) override;
+
+    /// Waits until all messages so far are passed to the target console.
+    void flush();
+
+    /// Number of messages dropped because the ring was full.
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct entry
+    {
+        msg_type type;
+        std::string text;
+        std::atomic<bool>* done; // set once written, for the waiting caller of an assert
+    };
+
+    void run();
+    void wake();
+    void drain();
+
+    console* m_target;
+    internal::mpsc_queue<entry> m_queue;
+
+    std::atomic<uint64_t> m_pushed;
+    std::atomic<uint64_t> m_written;
+    std::atomic<uint64_t> m_dropped;
+
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_sleeping;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+
+    std::thread m_thread;
+};
+
+}
+
+#endif
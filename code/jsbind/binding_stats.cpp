@@ -0,0 +1,218 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "binding_stats.hpp"
+#include "jsbind/common/deinitializers.hpp"
+
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+#if defined(JSBIND_BINDING_STATS)
+#   include <deque>
+#   include <mutex>
+#   include <unordered_map>
+#endif
+
+namespace jsbind
+{
+
+#if defined(JSBIND_BINDING_STATS)
+
+using namespace internal;
+
+namespace
+{
+
+// the counters of a thread
+// only the owning thread adds counters (under the mutex) and writes to them (without it)
+// other threads only read them, even to reset them
+struct shard
+{
+    std::mutex mutex;
+    std::deque<binding_counters> counters;
+};
+
+std::mutex registry_mutex;
+std::vector<std::string> binding_names;
+std::unordered_map<std::string, uint32_t> binding_ids;
+std::vector<instrumented_function*> instrumented_functions;
+std::vector<shard*> shards; // never freed, so the stats of finished threads are kept
+
+thread_local shard* this_thread_shard = nullptr;
+
+void merge(histogram::snapshot& a, const histogram::snapshot& b)
+{
+    for (size_t i = 0; i < histogram::num_buckets; ++i)
+    {
+        a.buckets[i] += b.buckets[i];
+    }
+    a.count += b.count;
+    a.sum += b.sum;
+    a.max = std::max(a.max, b.max);
+}
+
+void free_instrumented_functions()
+{
+    std::lock_guard<std::mutex> l(registry_mutex);
+    for (auto f : instrumented_functions)
+    {
+        delete f;
+    }
+    instrumented_functions.clear();
+}
+
+}
+
+namespace internal
+{
+
+std::atomic<uint32_t> binding_stats_generation(0);
+
+uint32_t register_binding(std::string name)
+{
+    std::lock_guard<std::mutex> l(registry_mutex);
+    auto f = binding_ids.find(name);
+    if (f != binding_ids.end()) return f->second;
+
+    auto id = uint32_t(binding_names.size());
+    binding_ids.emplace(name, id);
+    binding_names.emplace_back(std::move(name));
+    return id;
+}
+
+instrumented_function* new_instrumented_function(void* func, std::string name)
+{
+    auto ret = new instrumented_function{ func, register_binding(std::move(name)) };
+
+    std::lock_guard<std::mutex> l(registry_mutex);
+    if (instrumented_functions.empty())
+    {
+        add_deinitializer(free_instrumented_functions);
+    }
+    instrumented_functions.push_back(ret);
+    return ret;
+}
+
+binding_counters& get_binding_counters(uint32_t id)
+{
+    auto s = this_thread_shard;
+    if (!s || id >= s->counters.size())
+    {
+        std::lock_guard<std::mutex> l(registry_mutex);
+        if (!s)
+        {
+            s = this_thread_shard = new shard;
+            shards.push_back(s);
+        }
+
+        std::lock_guard<std::mutex> sl(s->mutex);
+        while (s->counters.size() < binding_names.size())
+        {
+            s->counters.emplace_back();
+        }
+    }
+
+    return s->counters[id];
+}
+
+}
+
+std::vector<binding_stat> binding_stats()
+{
+    std::lock_guard<std::mutex> l(registry_mutex);
+
+    std::vector<binding_stat> ret(binding_names.size());
+    for (size_t i = 0; i < ret.size(); ++i)
+    {
+        auto& stat = ret[i];
+        stat.name = binding_names[i];
+        stat.calls = stat.from_js_ns = stat.body_ns = stat.to_js_ns = 0;
+        stat.latency_ns = histogram::snapshot();
+    }
+
+    auto gen = binding_stats_generation.load(std::memory_order_relaxed);
+    for (auto s : shards)
+    {
+        std::lock_guard<std::mutex> sl(s->mutex);
+        for (size_t i = 0; i < s->counters.size(); ++i)
+        {
+            auto& c = s->counters[i];
+            if (c.generation.load(std::memory_order_acquire) != gen) continue; // reset
+
+            auto& stat = ret[i];
+            stat.calls += c.calls.load(std::memory_order_relaxed);
+            stat.from_js_ns += c.from_js_ns.load(std::memory_order_relaxed);
+            stat.body_ns += c.body_ns.load(std::memory_order_relaxed);
+            stat.to_js_ns += c.to_js_ns.load(std::memory_order_relaxed);
+            merge(stat.latency_ns, c.latency_ns.get());
+        }
+    }
+
+    ret.erase(std::remove_if(ret.begin(), ret.end(), [](const binding_stat& s) {
+        return s.calls == 0;
+    }), ret.end());
+
+    std::sort(ret.begin(), ret.end(), [](const binding_stat& a, const binding_stat& b) {
+        return a.total_ns() > b.total_ns();
+    });
+
+    return ret;
+}
+
+void reset_binding_stats()
+{
+    // the counters are cleared by their threads on their next call
+    std::lock_guard<std::mutex> l(registry_mutex);
+    binding_stats_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+#else
+
+std::vector<binding_stat> binding_stats()
+{
+    return std::vector<binding_stat>();
+}
+
+void reset_binding_stats()
+{
+}
+
+#endif
+
+void write_binding_stats(std::ostream& out)
+{
+    auto ms = [](uint64_t ns) { return double(ns) / 1000000; };
+    auto us = [](uint64_t ns) { return double(ns) / 1000; };
+
+    out << std::left << std::setw(40) << "binding" << std::right
+        << std::setw(10) << "calls"
+        << std::setw(12) << "total ms"
+        << std::setw(12) << "args ms"
+        << std::setw(12) << "body ms"
+        << std::setw(12) << "result ms"
+        << std::setw(10) << "mean us"
+        << std::setw(10) << "p99 us"
+        << std::setw(10) << "max us" << '\n';
+
+    out << std::fixed << std::setprecision(2);
+    for (auto& s : binding_stats())
+    {
+        out << std::left << std::setw(40) << s.name << std::right
+            << std::setw(10) << s.calls
+            << std::setw(12) << ms(s.total_ns())
+            << std::setw(12) << ms(s.from_js_ns)
+            << std::setw(12) << ms(s.body_ns)
+            << std::setw(12) << ms(s.to_js_ns)
+            << std::setw(10) << us(uint64_t(s.latency_ns.mean()))
+            << std::setw(10) << us(s.latency_ns.percentile(0.99))
+            << std::setw(10) << us(s.latency_ns.max) << '\n';
+    }
+}
+
+}
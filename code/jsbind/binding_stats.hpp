@@ -0,0 +1,173 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "jsbind/common/histogram.hpp"
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(JSBIND_BINDING_STATS)
+#   include <atomic>
+#   include <chrono>
+#endif
+
+namespace jsbind
+{
+
+/// Timing of the calls to a bound C++ function.
+/// Times are in nanoseconds. `from_js_ns` is the time spent converting the arguments,
+/// `body_ns` the time in the C++ function and `to_js_ns` the time converting the result.
+struct binding_stat
+{
+    std::string name;
+    uint64_t calls;
+    uint64_t from_js_ns;
+    uint64_t body_ns;
+    uint64_t to_js_ns;
+    histogram::snapshot latency_ns; // of whole calls
+
+    uint64_t total_ns() const { return from_js_ns + body_ns + to_js_ns; }
+};
+
+/// Stats of all bindings which were called, most expensive first.
+/// Bindings are instrumented only when jsbind is compiled with JSBIND_BINDING_STATS.
+/// Without it the result is always empty and the calls have no instrumentation at all.
+extern std::vector<binding_stat> binding_stats();
+
+/// Writes a table of `binding_stats()`.
+extern void write_binding_stats(std::ostream& out);
+
+extern void reset_binding_stats();
+
+#if defined(JSBIND_BINDING_STATS)
+namespace internal
+{
+    // incremented by `reset_binding_stats`
+    extern std::atomic<uint32_t> binding_stats_generation;
+
+    // counters of a binding in a thread
+    // only the owning thread writes to them, so they're updated with plain loads and stores
+    // instead of locked read-modify-writes. Other threads only read them.
+    struct binding_counters
+    {
+        binding_counters() : generation(0), calls(0), from_js_ns(0), body_ns(0), to_js_ns(0) {}
+
+        void add(uint64_t from_js, uint64_t body, uint64_t to_js)
+        {
+            // a reset only starts a new generation and the owning thread clears its own counters
+            auto gen = binding_stats_generation.load(std::memory_order_relaxed);
+            if (generation.load(std::memory_order_relaxed) != gen)
+            {
+                calls.store(0, std::memory_order_relaxed);
+                from_js_ns.store(0, std::memory_order_relaxed);
+                body_ns.store(0, std::memory_order_relaxed);
+                to_js_ns.store(0, std::memory_order_relaxed);
+                latency_ns.reset();
+                generation.store(gen, std::memory_order_release);
+            }
+
+            increase(calls, 1);
+            increase(from_js_ns, from_js);
+            increase(body_ns, body);
+            increase(to_js_ns, to_js);
+            latency_ns.record_unshared(from_js + body + to_js);
+        }
+
+        // counters of older generations count as zero
+        std::atomic<uint32_t> generation;
+
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> from_js_ns;
+        std::atomic<uint64_t> body_ns;
+        std::atomic<uint64_t> to_js_ns;
+        histogram latency_ns;
+
+    private:
+        static void increase(std::atomic<uint64_t>& a, uint64_t value)
+        {
+            a.store(a.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+    // returns the id of the binding with the name
+    // bindings registered again after reinitialization keep their ids
+    extern uint32_t register_binding(std::string name);
+
+    inline std::string binding_name(const char* class_name, const char* name)
+    {
+        return class_name ? std::string(class_name) + '.' + name : std::string(name);
+    }
+
+    // engine data of an instrumented function
+    struct instrumented_function
+    {
+        void* func;
+        uint32_t stats_id;
+    };
+
+    // freed on deinitialization
+    extern instrumented_function* new_instrumented_function(void* func, std::string name);
+
+    // the counters of a binding in the current thread
+    extern binding_counters& get_binding_counters(uint32_t id);
+
+    // measures the parts of a call to a binding
+    class binding_timer
+    {
+    public:
+        explicit binding_timer(uint32_t id)
+            : m_id(id)
+            , m_last(clock::now())
+        {}
+
+        void args_converted() { m_from_js = lap(); }
+        void body_done() { m_body = lap(); }
+
+        ~binding_timer()
+        {
+            auto to_js = lap();
+
+            get_binding_counters(m_id).add(m_from_js, m_body, to_js);
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        uint64_t lap()
+        {
+            auto now = clock::now();
+            auto ret = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last).count();
+            m_last = now;
+            return uint64_t(ret);
+        }
+
+        uint32_t m_id;
+        clock::time_point m_last;
+        uint64_t m_from_js = 0;
+        uint64_t m_body = 0;
+    };
+}
+#endif
+
+namespace internal
+{
+    // arguments converted ahead of the call are passed as rvalues, unless the function takes an lvalue reference
+    template <typename Arg, typename T>
+    typename std::conditional<std::is_lvalue_reference<Arg>::value, T&, T&&>::type
+        forward_converted(T& t)
+    {
+        return static_cast<typename std::conditional<std::is_lvalue_reference<Arg>::value, T&, T&&>::type>(t);
+    }
+}
+
+}
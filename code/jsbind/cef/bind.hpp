@@ -9,9 +9,13 @@
 #pragma once
 
 #include "value.hpp"
+#include "codec.hpp"
 
 #include "jsbind/common/ptr_cast.hpp"
 #include "jsbind/common/deinitializers.hpp"
+#include "jsbind/common/field_layout.hpp"
+
+#include <algorithm>
 
 namespace jsbind
 {
@@ -34,7 +38,7 @@ void function(const char* js_name, ReturnType(*func)(Args...))
     CefString cef_name;
     cef_name.FromASCII(js_name);
 
-    auto handler = new internal::cef_handler<ReturnType, Args...>(func);
+    auto handler = new internal::cef_handler<ReturnType, Args...>(func, nullptr, js_name);
     auto jsfunc = CefV8Value::CreateFunction(cef_name, handler);
 
     internal::class_data::global->SetValue(cef_name, jsfunc, V8_PROPERTY_ATTRIBUTE_NONE);
@@ -45,6 +49,7 @@ class class_ : private internal::class_data
 {
 public:
     class_(const char* js_name)
+        : m_name(js_name)
     {
         m_cef_func = CefV8Value::CreateObject(nullptr, nullptr);
 
@@ -59,7 +64,7 @@ public:
         CefString cef_name;
         cef_name.FromASCII(js_name);
 
-        auto handler = new internal::cef_handler<ReturnType, Args...>(class_func);
+        auto handler = new internal::cef_handler<ReturnType, Args...>(class_func, m_name, js_name);
         auto func = CefV8Value::CreateFunction(cef_name, handler);
 
         m_cef_func->SetValue(cef_name, func, V8_PROPERTY_ATTRIBUTE_NONE);
@@ -67,7 +72,7 @@ public:
     }
 
 private:
-
+    const char* m_name;
 };
 
 namespace internal
@@ -78,6 +83,9 @@ namespace internal
         void* pfield;
         void(*from_cef)(CefRefPtr<CefV8Value> value, void* obj, void* pfield);
         CefRefPtr<CefV8Value>(*to_cef)(const void* obj, void* pfield);
+        bool(*from_codec)(codec_reader& r, void* obj, void* pfield);
+        void(*to_codec)(codec_writer& w, const void* obj, void* pfield);
+        field_layout layout;
     };
 }
 
@@ -111,6 +119,22 @@ public:
         return internal::to_cef(t->*field);
     }
 
+    template <typename Field>
+    static bool field_from_codec(internal::codec_reader& r, void* obj, void* pfield)
+    {
+        auto t = reinterpret_cast<T*>(obj);
+        Field field = internal::ptr_cast<Field>(pfield);
+        return internal::codec_read(r, t->*field);
+    }
+
+    template <typename Field>
+    static void field_to_codec(internal::codec_writer& w, const void* obj, void* pfield)
+    {
+        auto t = reinterpret_cast<const T*>(obj);
+        Field field = internal::ptr_cast<Field>(pfield);
+        internal::codec_write(w, t->*field);
+    }
+
     template <typename Field>
     value_object& field(const char* js_name, Field field)
     {
@@ -119,7 +143,10 @@ public:
             internal::to_cef_string(js_name),
             internal::ptr_cast<Field>(field),
             field_from_cef<Field>,
-            field_to_cef<Field>
+            field_to_cef<Field>,
+            field_from_codec<Field>,
+            field_to_codec<Field>,
+            internal::make_field_layout<T>(js_name, field)
         };
         fields.emplace_back(std::move(f));
         return *this;
@@ -179,6 +206,47 @@ namespace internal
         return ret;
     }
 
+    template <typename T>
+    void write_value_object(codec_writer& w, const T& value)
+    {
+        assert(value_object<T>::is_bound && "encoding an unbound value_type");
+        auto& fields = value_object<T>::fields;
+        w.write_object(uint32_t(fields.size()));
+        for (auto& field : fields)
+        {
+            w.write_key(field.layout.name);
+            field.to_codec(w, &value, field.pfield);
+        }
+    }
+
+    // fields missing from the object are left as they are and unknown keys are skipped
+    template <typename T>
+    bool read_value_object(codec_reader& r, T& value)
+    {
+        assert(value_object<T>::is_bound && "decoding an unbound value_type");
+        uint32_t length;
+        if (!r.read_object(length)) return false;
+
+        auto& fields = value_object<T>::fields;
+        bool ok = true;
+        std::string key;
+        for (uint32_t i = 0; i < length && !r.failed(); ++i)
+        {
+            if (!r.read_key(key)) break;
+
+            auto field = std::find_if(fields.begin(), fields.end(),
+                [&key](const value_object_field& f) { return f.layout.name == key; });
+            if (field == fields.end())
+            {
+                r.skip();
+                continue;
+            }
+
+            ok = field->from_codec(r, &value, field->pfield) && ok;
+        }
+        return ok && !r.failed();
+    }
+
 }
 
 }
@@ -11,6 +11,8 @@
 #include "jsbind/error.hpp"
 #include "jsbind/common/index_sequence.hpp"
 #include "jsbind/common/function_traits.hpp"
+#include "jsbind/binding_stats.hpp"
+#include "jsbind/watchdog.hpp"
 #include "convert.hpp"
 
 #include <tuple>
@@ -26,6 +28,7 @@ namespace internal
         // +1 so when there are zero args we at least have something
         CefV8ValueList cef_args = { internal::to_cef(args)... };
 
+        watchdog_scope watch(false);
         auto result = func->ExecuteFunction(self, cef_args);
 
         if (func->HasException())
@@ -55,6 +58,38 @@ namespace internal
         return CefV8Value::CreateUndefined();
     }
 
+#if defined(JSBIND_BINDING_STATS)
+    // same as tuple_call, but the arguments are converted ahead, so that each part of the call can be timed
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<!is_void_return<Func>::value,
+        CefRefPtr<CefV8Value>>::type timed_tuple_call(uint32_t stats_id, Func func, const CefV8ValueList& args, index_sequence<Seq...>)
+    {
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::type...> converted{
+            from_cef<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
+
+        auto&& result = func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
+
+        return to_cef(result);
+    }
+
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<is_void_return<Func>::value,
+        CefRefPtr<CefV8Value>>::type timed_tuple_call(uint32_t stats_id, Func func, const CefV8ValueList& args, index_sequence<Seq...>)
+    {
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::type...> converted{
+            from_cef<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
+
+        func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
+
+        return CefV8Value::CreateUndefined();
+    }
+#endif
 
     template <typename ReturnType, typename... Args>
     class cef_handler : public CefV8Handler
@@ -62,18 +97,31 @@ namespace internal
         IMPLEMENT_REFCOUNTING(cef_handler);
 
     public:
-        cef_handler(ReturnType(*cxx_func)(Args...))
+        cef_handler(ReturnType(*cxx_func)(Args...), const char* class_name, const char* name)
             : m_cxx_func(cxx_func)
-        {}
+#if defined(JSBIND_BINDING_STATS)
+            , m_stats_id(register_binding(binding_name(class_name, name)))
+#endif
+        {
+            (void)class_name;
+            (void)name;
+        }
 
         virtual bool Execute(const CefString& /*name*/, CefRefPtr<CefV8Value> /*object*/, const CefV8ValueList& arguments, CefRefPtr<CefV8Value>& retval, CefString& /*exception*/) override
         {
             JSBIND_JS_CHECK((unsigned long)arguments.size() >= sizeof...(Args), "Not enough arguments for function.");
+#if defined(JSBIND_BINDING_STATS)
+            retval = timed_tuple_call<std::tuple<Args...>>(m_stats_id, m_cxx_func, arguments, make_index_sequence<sizeof...(Args)>());
+#else
             retval = tuple_call<std::tuple<Args...>>(m_cxx_func, arguments, make_index_sequence<sizeof...(Args)>());
+#endif
             return true;
         }
 
         ReturnType(*m_cxx_func)(Args...);
+#if defined(JSBIND_BINDING_STATS)
+        uint32_t m_stats_id;
+#endif
     };
 }
 }
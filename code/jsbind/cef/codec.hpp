@@ -0,0 +1,437 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "global.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+namespace jsbind
+{
+
+class local;
+
+namespace internal
+{
+    // the c++ side of the bytes of `serialize` on engines with no serializer of their own
+    // (see the codec in serialization.cpp), so they can be read and written with no js engine
+    // numbers are little endian and strings are utf-16
+    enum class codec_tag : uint8_t
+    {
+        undefined, null, boolean_false, boolean_true, number, string, array, object, buffer, view, date, ref
+    };
+
+    class codec_writer
+    {
+    public:
+        void write_undefined() { tag(codec_tag::undefined); }
+        void write_null() { tag(codec_tag::null); }
+        void write_bool(bool b) { tag(b ? codec_tag::boolean_true : codec_tag::boolean_false); }
+
+        void write_number(double d)
+        {
+            tag(codec_tag::number);
+            raw(&d, sizeof(d));
+        }
+
+        void write_string(const std::string& utf8)
+        {
+            tag(codec_tag::string);
+            chars(utf8);
+        }
+
+        // to be followed by `length` values
+        void write_array(uint32_t length)
+        {
+            tag(codec_tag::array);
+            raw(&length, sizeof(length));
+        }
+
+        // to be followed by `length` keys, each followed by its value
+        void write_object(uint32_t length)
+        {
+            tag(codec_tag::object);
+            raw(&length, sizeof(length));
+        }
+
+        void write_key(const std::string& key)
+        {
+            chars(key);
+        }
+
+        void append(const codec_writer& other)
+        {
+            m_data.insert(m_data.end(), other.m_data.begin(), other.m_data.end());
+        }
+
+        void clear() { m_data.clear(); }
+
+        const std::vector<uint8_t>& data() const { return m_data; }
+
+    private:
+        void tag(codec_tag t) { m_data.push_back(uint8_t(t)); }
+
+        void raw(const void* data, size_t size)
+        {
+            auto p = reinterpret_cast<const uint8_t*>(data);
+            m_data.insert(m_data.end(), p, p + size);
+        }
+
+        void chars(const std::string& utf8)
+        {
+            CefStringUTF16 str(utf8);
+            auto length = uint32_t(str.length());
+            raw(&length, sizeof(length));
+            raw(str.c_str(), length * sizeof(CefStringUTF16::char_type));
+        }
+
+        std::vector<uint8_t> m_data;
+    };
+
+    class codec_reader
+    {
+    public:
+        codec_reader(const uint8_t* data, size_t size)
+            : m_data(data)
+            , m_size(size)
+        {}
+
+        // set when the bytes are truncated or corrupt, after which nothing more can be read
+        // reading a value of another type only returns false and skips the value
+        bool failed() const { return m_failed; }
+
+        bool at_end() const { return m_pos == m_size; }
+
+        bool read_number(double& d)
+        {
+            if (!expect(codec_tag::number)) return false;
+            return raw(&d, sizeof(d));
+        }
+
+        bool read_bool(bool& b)
+        {
+            if (next_is(codec_tag::boolean_true) || next_is(codec_tag::boolean_false))
+            {
+                b = m_data[m_pos++] == uint8_t(codec_tag::boolean_true);
+                return true;
+            }
+            skip();
+            return false;
+        }
+
+        bool read_string(std::string& utf8)
+        {
+            if (!expect(codec_tag::string)) return false;
+            return read_key(utf8);
+        }
+
+        // the values follow
+        bool read_array(uint32_t& length)
+        {
+            if (!expect(codec_tag::array)) return false;
+            return raw(&length, sizeof(length));
+        }
+
+        // the keys and values follow
+        bool read_object(uint32_t& length)
+        {
+            if (!expect(codec_tag::object)) return false;
+            return raw(&length, sizeof(length));
+        }
+
+        bool read_key(std::string& utf8)
+        {
+            uint32_t length;
+            if (!raw(&length, sizeof(length))) return false;
+
+            // the chars may be unaligned
+            m_chars.resize(length);
+            if (!raw(m_chars.data(), length * sizeof(CefStringUTF16::char_type))) return false;
+
+            utf8 = CefStringUTF16(m_chars.data(), length, false).ToString();
+            return true;
+        }
+
+        void skip()
+        {
+            if (!check(1)) return;
+
+            auto start = m_pos;
+            auto t = codec_tag(m_data[m_pos++]);
+            uint32_t length = 0;
+            switch (t)
+            {
+            case codec_tag::undefined:
+            case codec_tag::null:
+            case codec_tag::boolean_false:
+            case codec_tag::boolean_true:
+                break;
+            case codec_tag::number:
+                advance(8);
+                break;
+            case codec_tag::string:
+                if (raw(&length, sizeof(length))) advance(size_t(length) * 2);
+                break;
+            case codec_tag::ref:
+                advance(4);
+                break;
+            case codec_tag::date:
+                note_object(start);
+                advance(8);
+                break;
+            case codec_tag::buffer:
+                note_object(start);
+                if (raw(&length, sizeof(length))) advance(length);
+                break;
+            case codec_tag::view:
+                note_object(start);
+                advance(1);
+                if (raw(&length, sizeof(length))) advance(length);
+                break;
+            case codec_tag::array:
+                note_object(start);
+                if (!raw(&length, sizeof(length))) break;
+                for (uint32_t i = 0; i < length && !m_failed; ++i) skip();
+                break;
+            case codec_tag::object:
+                note_object(start);
+                if (!raw(&length, sizeof(length))) break;
+                for (uint32_t i = 0; i < length && !m_failed; ++i)
+                {
+                    uint32_t key_length;
+                    if (raw(&key_length, sizeof(key_length))) advance(size_t(key_length) * 2);
+                    skip();
+                }
+                break;
+            default:
+                m_failed = true;
+            }
+        }
+
+        // the encoder writes objects which appear more than once as references to the first one
+        // while the scope lives the reader is at the referenced value, which is read again
+        class ref_scope
+        {
+        public:
+            explicit ref_scope(codec_reader& r)
+                : m_reader(r)
+                , m_resume(0)
+                , m_followed(false)
+            {
+                if (!r.next_is(codec_tag::ref)) return;
+
+                ++r.m_pos;
+                uint32_t index;
+                if (!r.raw(&index, sizeof(index))) return;
+
+                // cyclic values have no c++ counterpart
+                if (index >= r.m_objects.size() || r.m_ref_depth == max_ref_depth)
+                {
+                    r.m_failed = true;
+                    return;
+                }
+
+                m_resume = r.m_pos;
+                m_followed = true;
+                ++r.m_ref_depth;
+                r.m_pos = r.m_objects[index];
+            }
+
+            ~ref_scope()
+            {
+                if (!m_followed) return;
+                --m_reader.m_ref_depth;
+                m_reader.m_pos = m_resume;
+            }
+
+        private:
+            codec_reader& m_reader;
+            size_t m_resume;
+            bool m_followed;
+        };
+
+    private:
+        static const int max_ref_depth = 32;
+
+        bool next_is(codec_tag t) const
+        {
+            return m_pos < m_size && m_data[m_pos] == uint8_t(t);
+        }
+
+        bool expect(codec_tag t)
+        {
+            if (next_is(t))
+            {
+                if (t == codec_tag::array || t == codec_tag::object) note_object(m_pos);
+                ++m_pos;
+                return true;
+            }
+
+            skip();
+            return false;
+        }
+
+        // the references are indices of the objects in the order they first appear
+        // values read again through a reference are before the last noted object, so they aren't noted twice
+        void note_object(size_t pos)
+        {
+            if (m_objects.empty() || pos > m_objects.back())
+            {
+                m_objects.push_back(pos);
+            }
+        }
+
+        bool check(size_t size)
+        {
+            if (m_failed || m_size - m_pos < size)
+            {
+                m_failed = true;
+                return false;
+            }
+            return true;
+        }
+
+        void advance(size_t size)
+        {
+            if (check(size)) m_pos += size;
+        }
+
+        bool raw(void* out, size_t size)
+        {
+            if (!check(size)) return false;
+            memcpy(out, m_data + m_pos, size);
+            m_pos += size;
+            return true;
+        }
+
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_pos = 0;
+        bool m_failed = false;
+        int m_ref_depth = 0;
+        std::vector<size_t> m_objects;
+        std::vector<CefStringUTF16::char_type> m_chars;
+    };
+
+    template <typename T>
+    void write_value_object(codec_writer& w, const T& value);
+
+    template <typename T>
+    bool read_value_object(codec_reader& r, T& value);
+
+    // the codec of a c++ type
+    // class types are value_objects, unless there is a specialization
+    template <typename T, typename Enable = void>
+    struct codec
+    {
+        static void write(codec_writer& w, const T& value)
+        {
+            write_value_object(w, value);
+        }
+
+        static bool read(codec_reader& r, T& value)
+        {
+            return read_value_object(r, value);
+        }
+    };
+
+    template <typename T>
+    bool codec_read(codec_reader& r, T& value)
+    {
+        codec_reader::ref_scope ref(r);
+        return !r.failed() && codec<T>::read(r, value);
+    }
+
+    template <typename T>
+    void codec_write(codec_writer& w, const T& value)
+    {
+        codec<T>::write(w, value);
+    }
+
+    template <>
+    struct codec<bool>
+    {
+        static void write(codec_writer& w, bool value) { w.write_bool(value); }
+        static bool read(codec_reader& r, bool& value) { return r.read_bool(value); }
+    };
+
+    template <typename T>
+    struct codec<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    {
+        static void write(codec_writer& w, T value) { w.write_number(double(value)); }
+
+        static bool read(codec_reader& r, T& value)
+        {
+            double d;
+            if (!r.read_number(d)) return false;
+            value = T(d);
+            return true;
+        }
+    };
+
+    template <>
+    struct codec<std::string>
+    {
+        static void write(codec_writer& w, const std::string& value) { w.write_string(value); }
+        static bool read(codec_reader& r, std::string& value) { return r.read_string(value); }
+    };
+
+    template <typename T, typename A>
+    struct codec<std::vector<T, A>>
+    {
+        static void write(codec_writer& w, const std::vector<T, A>& value)
+        {
+            w.write_array(uint32_t(value.size()));
+            for (auto& elem : value)
+            {
+                codec_write(w, elem);
+            }
+        }
+
+        static bool read(codec_reader& r, std::vector<T, A>& value)
+        {
+            uint32_t length;
+            if (!r.read_array(length)) return false;
+
+            bool ok = true;
+            value.clear();
+            value.reserve(length);
+            for (uint32_t i = 0; i < length && !r.failed(); ++i)
+            {
+                T elem = T();
+                ok = codec_read(r, elem) && ok;
+                value.push_back(std::move(elem));
+            }
+            return ok && !r.failed();
+        }
+    };
+
+    // js values don't exist outside of their engine
+    template <>
+    struct codec<local>
+    {
+        static void write(codec_writer& w, const local&)
+        {
+            assert(false && "a js value can't be encoded");
+            w.write_undefined();
+        }
+
+        static bool read(codec_reader& r, local&)
+        {
+            r.skip();
+            return false;
+        }
+    };
+}
+}
@@ -26,7 +26,8 @@ namespace jsbind
 namespace internal
 {
     extern CefRefPtr<CefV8Context> cef_context;
-    extern CefRefPtr<CefV8Value> make_uint8_array_func;
+    extern CefRefPtr<CefV8Value> make_typed_array_func;
+    extern CefRefPtr<CefV8Value> array_buffer_chars_func;
 
     extern void report_exception(CefRefPtr<CefV8Exception> exception);
 }
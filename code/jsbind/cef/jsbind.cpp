@@ -11,6 +11,8 @@
 #include "global.hpp"
 #include "jsbind/console.hpp"
 #include "jsbind/exception.hpp"
+#include "jsbind/watchdog.hpp"
+#include "jsbind/post.hpp"
 #include "jsbind/common/deinitializers.hpp"
 
 #include <sstream>
@@ -29,28 +31,54 @@ namespace jsbind
 namespace internal
 {
     CefRefPtr<CefV8Context> cef_context = nullptr;
-    CefRefPtr<CefV8Value> make_uint8_array_func = nullptr;
+    CefRefPtr<CefV8Value> make_typed_array_func = nullptr;
+    CefRefPtr<CefV8Value> array_buffer_chars_func = nullptr;
 
     extern void initialize_bindings();
 
     CefRefPtr<CefV8Value> class_data::global = nullptr;
 
+    namespace
+    {
+    class cef_exception_info : public exception_info
+    {
+    public:
+        explicit cef_exception_info(CefRefPtr<CefV8Exception> exception)
+            : m_exception(exception)
+        {}
+
+        virtual std::string message() const override { return m_exception->GetMessage().ToString(); }
+        virtual std::string resource() const override { return m_exception->GetScriptResourceName().ToString(); }
+        virtual int line() const override { return m_exception->GetLineNumber(); }
+        virtual int start_column() const override { return m_exception->GetStartColumn(); }
+        virtual int end_column() const override { return m_exception->GetEndColumn(); }
+        virtual std::string source_line() const override { return m_exception->GetSourceLine().ToString(); }
+
+        // cef doesn't provide the stack of exceptions
+        virtual std::vector<stack_frame> frames() const override { return std::vector<stack_frame>(); }
+
+        virtual std::string text() const override
+        {
+            stringstream ss;
+
+            ss << resource() << ":" << line() << " " << message() << endl;
+            ss << "    at `" << source_line() << "`";
+
+            return ss.str();
+        }
+
+    private:
+        CefRefPtr<CefV8Exception> m_exception;
+    };
+    }
+
     void report_exception(CefRefPtr<CefV8Exception> exception)
     {
         auto eh = get_exception_handler();
         if (!eh) return;
 
-        string msg = exception->GetMessage().ToString();
-        string resource = exception->GetScriptResourceName().ToString();
-        string line = exception->GetSourceLine().ToString();
-
-        // consider using string stream here
-        stringstream ss;
-
-        ss << resource << ":" << exception->GetLineNumber() << " " << msg << endl;
-        ss << "    at `" << line << "`";
-
-        eh->on_exception(ss.str().c_str());
+        cef_exception_info info(exception);
+        eh->on_exception_info(info);
     }
 }
 
@@ -62,12 +90,23 @@ void initialize()
 
     // no console in cef (use browser console)
 
-    // hacky make uint8array function
+    // hacky make typed array function
+    // cef can create array buffers, but not typed arrays over them
     {
         CefString code;
-        code.FromASCII("(function (arrayBuf) { return new Uint8Array(arrayBuf); })");
+        code.FromASCII("(function (g) { return function (arrayBuf, type) { return new g[type](arrayBuf); }; })(this)");
         CefRefPtr<CefV8Exception> exception;
-        cef_context->Eval(code, "jsbind.init", 0, make_uint8_array_func, exception);
+        cef_context->Eval(code, "jsbind.init", 0, make_typed_array_func, exception);
+    }
+
+    // nor can it read their bytes, which are copied through a string of a char per byte instead
+    {
+        CefString code;
+        code.FromASCII("(function (arrayBuf, offset, length) { var b = new Uint8Array(arrayBuf, offset || 0, length), s = '';"
+            " for (var i = 0; i < b.length; i += 8192) s += String.fromCharCode.apply(null, b.subarray(i, i + 8192));"
+            " return s; })");
+        CefRefPtr<CefV8Exception> exception;
+        cef_context->Eval(code, "jsbind.init", 0, array_buffer_chars_func, exception);
     }
 
     // init bindings
@@ -80,13 +119,16 @@ void initialize()
     auto str_module = to_cef_string("Module");
     global->SetValue(str_module, class_data::global, V8_PROPERTY_ATTRIBUTE_NONE);
     class_data::global = nullptr;
+
+    initialize_posted_tasks();
 }
 
 void deinitialize()
 {
     internal::run_deinitializers();
 
-    make_uint8_array_func = nullptr;
+    make_typed_array_func = nullptr;
+    array_buffer_chars_func = nullptr;
 
     CefV8Context* ctx = nullptr;
     cef_context.swap(&ctx);
@@ -111,6 +153,7 @@ void run_script(const char* src, const char* fname)
 
     CefRefPtr<CefV8Value> ret;
     CefRefPtr<CefV8Exception> exception;
+    watchdog_scope watch(true);
     auto success = cef_context->Eval(code, fname, 0, ret, exception);
 
     if (!success)
@@ -0,0 +1,316 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "cef_bridge.hpp"
+
+#if defined(JSBIND_CEF)
+
+#include "funcs.hpp"
+#include "serialization.hpp"
+#include "jsbind/common/deinitializers.hpp"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <include/cef_task.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#include <exception>
+
+using namespace jsbind::internal;
+
+namespace
+{
+
+const char* const call_message = "jsbind.bridge.call";
+const char* const reply_message = "jsbind.bridge.reply";
+
+// the calls waiting to be sent and the promises waiting for replies
+// a batch is [[id, name, args], ...] and a reply is [[id, succeeded, result or error], ...]
+// each sent batch gets one reply, in order. The calls of a batch missing from its reply
+// (as when the batch is corrupt) are rejected, so that no promise waits forever
+const char* const bridge_src = R"js(
+(function () {
+    var queue = [], pending = {}, sent = [], nextId = 1;
+    function settleCalls(replies) {
+        for (var i = 0; i < replies.length; ++i) {
+            var r = replies[i], p = pending[r[0]];
+            if (!p) continue;
+            delete pending[r[0]];
+            if (r[1]) p[0](r[2]);
+            else p[1](new Error(r[2]));
+        }
+    }
+    return {
+        call: function (name, args) {
+            var id = nextId++;
+            // a copy, so that the same array in two calls isn't encoded as a reference
+            queue.push([id, name, Array.prototype.slice.call(args || [])]);
+            return new Promise(function (resolve, reject) { pending[id] = [resolve, reject]; });
+        },
+        take: function () {
+            var batch = queue;
+            queue = [];
+            return batch;
+        },
+        sent: function (batch) {
+            sent.push(batch.map(function (call) { return call[0]; }));
+        },
+        // replies to calls which weren't sent
+        reject: settleCalls,
+        settle: function (replies) {
+            var ids = sent.shift() || [];
+            settleCalls(replies || []);
+            for (var j = 0; j < ids.length; ++j) {
+                var q = pending[ids[j]];
+                if (!q) continue;
+                delete pending[ids[j]];
+                q[1](new Error('jsbind: no reply to the bridge call'));
+            }
+        }
+    };
+})()
+)js";
+
+jsbind::persistent bridge;
+bool flush_posted = false;
+
+void clear_bridge()
+{
+    bridge.reset();
+    flush_posted = false;
+}
+
+jsbind::local get_bridge()
+{
+    if (bridge.is_empty())
+    {
+        bridge.reset(jsbind::local::global("eval")(bridge_src));
+        add_deinitializer(clear_bridge);
+    }
+
+    return bridge.to_local();
+}
+
+// sends the calls made in a renderer task after it
+class flush_task : public CefTask
+{
+public:
+    virtual void Execute() override
+    {
+        if (!flush_posted) return; // deinitialized
+        flush_posted = false;
+
+        jsbind::enter_context();
+        jsbind::flush_bridge_calls();
+        jsbind::exit_context();
+    }
+
+private:
+    IMPLEMENT_REFCOUNTING(flush_task);
+};
+
+std::vector<uint8_t> binary_contents(CefRefPtr<CefProcessMessage> message)
+{
+    std::vector<uint8_t> ret;
+    auto bin = message->GetArgumentList()->GetBinary(0);
+    if (bin)
+    {
+        ret.resize(bin->GetSize());
+        bin->GetData(ret.data(), ret.size(), 0);
+    }
+    return ret;
+}
+
+CefRefPtr<CefProcessMessage> make_message(const char* name, const std::vector<uint8_t>& data)
+{
+    auto ret = CefProcessMessage::Create(name);
+    ret->GetArgumentList()->SetBinary(0, CefBinaryValue::Create(data.data(), data.size()));
+    return ret;
+}
+
+// encodes the calls of a batch one by one, rejecting the ones which can't be encoded
+// returns the batch of the calls which remain
+jsbind::local remove_unencodable_calls(const jsbind::local& batch)
+{
+    auto sendable = jsbind::local::array();
+    auto rejected = jsbind::local::array();
+    uint32_t num_sendable = 0, num_rejected = 0;
+
+    auto length = batch["length"].as<uint32_t>();
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        auto call = batch[i];
+        if (serialize(call).empty())
+        {
+            auto reply = jsbind::local::array();
+            reply.set(0, call[0]);
+            reply.set(1, false);
+            reply.set(2, "jsbind: can't encode the arguments of " + call[1].as<std::string>());
+            rejected.set(num_rejected++, reply);
+        }
+        else
+        {
+            sendable.set(num_sendable++, call);
+        }
+    }
+
+    get_bridge().call<void>("reject", rejected);
+    return sendable;
+}
+
+}
+
+namespace jsbind
+{
+
+local bridge_call(const std::string& name, const local& args)
+{
+    auto promise = get_bridge().call<local>("call", name, args);
+
+    if (!flush_posted)
+    {
+        flush_posted = true;
+        CefPostTask(TID_RENDERER, new flush_task);
+    }
+
+    return promise;
+}
+
+void flush_bridge_calls()
+{
+    if (bridge.is_empty()) return;
+
+    auto batch = get_bridge().call<local>("take");
+    if (batch["length"].as<uint32_t>() == 0) return;
+
+    auto bytes = serialize(batch);
+    if (bytes.empty())
+    {
+        // the exception is already reported
+        // only the calls which can't be encoded are rejected, the rest are sent as usual
+        batch = remove_unencodable_calls(batch);
+        if (batch["length"].as<uint32_t>() == 0) return;
+
+        bytes = serialize(batch);
+        if (bytes.empty()) return;
+    }
+
+    cef_context->GetBrowser()->SendProcessMessage(PID_BROWSER, make_message(call_message, bytes.data()));
+    get_bridge().call<void>("sent", batch);
+}
+
+bool on_bridge_reply(CefRefPtr<CefProcessMessage> message)
+{
+    if (message->GetName() != reply_message) return false;
+
+    // replies arriving after deinitialization are of promises which don't exist anymore
+    if (bridge.is_empty()) return true;
+
+    serialized_value replies(binary_contents(message));
+
+    enter_context();
+    get_bridge().call<void>("settle", deserialize(replies));
+    exit_context();
+
+    return true;
+}
+
+bool bridge_host::on_message(CefRefPtr<CefBrowser> browser, CefRefPtr<CefProcessMessage> message)
+{
+    if (message->GetName() != call_message) return false;
+
+    auto data = binary_contents(message);
+    codec_reader r(data.data(), data.size());
+
+    uint32_t num_calls = 0;
+    r.read_array(num_calls);
+
+    // a corrupt batch can't be read past the error, so only the calls before it are replied to
+    // the renderer rejects the calls of the batch which get no reply
+    uint32_t num_replies = 0;
+    codec_writer body;
+    std::string name;
+    for (uint32_t i = 0; i < num_calls; ++i)
+    {
+        uint32_t length, num_args;
+        double id;
+        if (!r.read_array(length) || length != 3
+            || !r.read_number(id) || !r.read_string(name) || !r.read_array(num_args))
+        {
+            assert(false && "corrupt bridge call");
+            break;
+        }
+
+        m_result.clear();
+        bool ok = false;
+        std::string error;
+        auto h = m_handlers.find(name);
+        if (h != m_handlers.end())
+        {
+            // the arguments are read before the handler is called, so the reader is past them
+            try
+            {
+                ok = h->second(r, num_args, m_result);
+            }
+            catch (const std::exception& e)
+            {
+                error = "jsbind: bridge handler " + name + " threw: " + e.what();
+            }
+            catch (...)
+            {
+                error = "jsbind: bridge handler " + name + " threw";
+            }
+        }
+        else
+        {
+            for (uint32_t a = 0; a < num_args; ++a) r.skip();
+        }
+
+        if (r.failed())
+        {
+            assert(false && "corrupt bridge call");
+            break;
+        }
+
+        body.write_array(3);
+        body.write_number(id);
+        body.write_bool(ok);
+        if (ok)
+        {
+            body.append(m_result);
+        }
+        else if (!error.empty())
+        {
+            body.write_string(error);
+        }
+        else if (h == m_handlers.end())
+        {
+            body.write_string("jsbind: no bridge handler " + name);
+        }
+        else
+        {
+            body.write_string("jsbind: wrong arguments of " + name);
+        }
+        ++num_replies;
+    }
+
+    codec_writer replies;
+    replies.write_array(num_replies);
+    replies.append(body);
+    browser->SendProcessMessage(PID_RENDERER, make_message(reply_message, replies.data()));
+
+    return true;
+}
+
+}
+
+#endif
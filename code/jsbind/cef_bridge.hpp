@@ -0,0 +1,171 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#if defined(JSBIND_CEF)
+
+#include "bind.hpp"
+#include "binding_stats.hpp"
+#include "jsbind/common/index_sequence.hpp"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+#include <include/cef_browser.h>
+#include <include/cef_process_message.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#include <functional>
+#include <unordered_map>
+#include <string>
+#include <tuple>
+
+namespace jsbind
+{
+
+/// Calls from js in the renderer process to C++ handlers in the browser process.
+///
+/// Calls are queued and all calls made in one renderer task are sent after it in a single
+/// process message. Each call returns a promise which is resolved with the result of the
+/// handler, or rejected if there is no such handler, the arguments can't be encoded or
+/// don't match it, or the handler throws.
+/// Arguments and results are encoded as with `serialize`, so they can be numbers, strings,
+/// arrays and objects. value_objects and vectors are converted by their fields on both sides.
+///
+/// `bridge_call` can be bound as any other function:
+///
+///     jsbind::function("engine", jsbind::bridge_call);
+///     // js: Module.engine('setPosition', [{ x: 1, y: 2 }]).then(function (r) { ... });
+///
+/// The renderer has to pass the replies with `on_bridge_reply` from
+/// `CefRenderProcessHandler::OnProcessMessageReceived`.
+///
+/// Returns the promise of the result. Must be called in the context.
+extern local bridge_call(const std::string& name, const local& args);
+
+/// Same as `bridge_call` with the arguments converted from C++.
+template <typename... Args>
+local bridge_invoke(const std::string& name, const Args&... args)
+{
+    auto array = local::array();
+    uint32_t i = 0;
+    int unused[] = { 0, (array.set(i++, args), 0)... };
+    (void)unused;
+    return bridge_call(name, array);
+}
+
+/// Sends the queued calls now instead of after the current task.
+extern void flush_bridge_calls();
+
+/// Settles the promises of the calls with the replies of the browser process.
+/// Returns false for messages which aren't bridge replies. Must be called out of the context.
+extern bool on_bridge_reply(CefRefPtr<CefProcessMessage> message);
+
+namespace internal
+{
+    template <typename T>
+    using bridge_arg = typename std::remove_cv<typename std::remove_reference<T>::type>::type;
+
+    template <typename Tuple, size_t... Seq>
+    void read_bridge_args(codec_reader& r, uint32_t num_args, Tuple& args, bool& ok, index_sequence<Seq...>)
+    {
+        int unused[] = { 0, (ok = (Seq < num_args && codec_read(r, std::get<Seq>(args))) && ok, 0)... };
+        (void)unused;
+
+        for (uint32_t i = sizeof...(Seq); i < num_args && !r.failed(); ++i)
+        {
+            r.skip();
+        }
+        ok = ok && !r.failed();
+    }
+
+    template <typename ReturnType>
+    struct bridge_result
+    {
+        template <typename... Args, typename Tuple, size_t... Seq>
+        static void call(codec_writer& w, const std::function<ReturnType(Args...)>& func, Tuple& args, index_sequence<Seq...>)
+        {
+            codec_write(w, func(forward_converted<Args>(std::get<Seq>(args))...));
+        }
+    };
+
+    template <>
+    struct bridge_result<void>
+    {
+        template <typename... Args, typename Tuple, size_t... Seq>
+        static void call(codec_writer& w, const std::function<void(Args...)>& func, Tuple& args, index_sequence<Seq...>)
+        {
+            func(forward_converted<Args>(std::get<Seq>(args))...);
+            w.write_undefined();
+        }
+    };
+
+    // decodes the arguments and writes the result of the call
+    // all arguments are read even when one doesn't match, so that the reader is after them
+    template <typename ReturnType, typename... Args>
+    bool bridge_dispatch(const std::function<ReturnType(Args...)>& func, codec_reader& r, uint32_t num_args, codec_writer& result)
+    {
+        std::tuple<bridge_arg<Args>...> args;
+
+        bool ok = num_args >= sizeof...(Args);
+        read_bridge_args(r, num_args, args, ok, make_index_sequence<sizeof...(Args)>());
+        if (!ok) return false;
+
+        bridge_result<ReturnType>::call(result, func, args, make_index_sequence<sizeof...(Args)>());
+        return true;
+    }
+}
+
+/// The handlers of bridge calls in the browser process.
+///
+/// The browser process needs no js engine and jsbind isn't initialized in it, but the
+/// value_objects of the handler arguments and results have to be declared in it too
+/// (bindings don't run there), so that their fields are known:
+///
+///     jsbind::value_object<vec>("vec").field("x", &vec::x).field("y", &vec::y);
+///     host.handler("setPosition", set_position); // void set_position(const vec& pos)
+///
+/// Pass the messages of the renderer to `on_message` from `CefClient::OnProcessMessageReceived`.
+class bridge_host
+{
+public:
+    template <typename ReturnType, typename... Args>
+    bridge_host& handler(const std::string& name, ReturnType(*func)(Args...))
+    {
+        return handler(name, std::function<ReturnType(Args...)>(func));
+    }
+
+    template <typename ReturnType, typename... Args>
+    bridge_host& handler(const std::string& name, std::function<ReturnType(Args...)> func)
+    {
+        m_handlers[name] = [func](internal::codec_reader& r, uint32_t num_args, internal::codec_writer& result) {
+            return internal::bridge_dispatch(func, r, num_args, result);
+        };
+        return *this;
+    }
+
+    /// Runs the calls of a message from the renderer and sends their results back in one message.
+    /// A handler which throws rejects its call with the message of the exception.
+    /// Returns false for messages which aren't bridge calls.
+    bool on_message(CefRefPtr<CefBrowser> browser, CefRefPtr<CefProcessMessage> message);
+
+private:
+    using dispatcher = std::function<bool(internal::codec_reader&, uint32_t, internal::codec_writer&)>;
+    std::unordered_map<std::string, dispatcher> m_handlers;
+
+    // reused between calls
+    internal::codec_writer m_result;
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "function_traits.hpp"
+#include "typed_array_traits.hpp"
+
+#include <tuple>
+#include <string>
+#include <type_traits>
+
+namespace jsbind
+{
+
+/// Marks a struct which is sent as a `packed_array`. All value_object fields of a marked
+/// struct have to be numbers, which is checked when they are declared. Specialize it
+/// before the value_object of the struct:
+///
+///     namespace jsbind { template <> struct packed_struct<vec> : std::true_type {}; }
+template <typename T>
+struct packed_struct : std::false_type {};
+
+namespace internal
+{
+
+    // name, position and type of a value_object field within its struct
+    struct field_layout
+    {
+        std::string name;
+        size_t offset;
+        size_t size;
+        typed_array_type type; // none for fields which can't be viewed by typed arrays
+    };
+
+    template <typename T, typename Field>
+    field_layout make_field_layout(const char* js_name, Field field)
+    {
+        using FieldType = typename std::remove_cv<typename function_traits<Field>::return_type>::type;
+        static_assert(!packed_struct<T>::value || has_typed_array<FieldType>::value,
+            "the fields of a packed_struct must be numbers");
+
+        // no object is constructed, only the address of the field is needed
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+        auto obj = reinterpret_cast<const T*>(&storage);
+        auto offset = reinterpret_cast<const char*>(&(obj->*field)) - reinterpret_cast<const char*>(obj);
+
+        field_layout ret = { js_name, size_t(offset), sizeof(FieldType), typed_array_traits<FieldType>::type };
+        return ret;
+    }
+
+}
+}
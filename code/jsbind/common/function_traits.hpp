@@ -8,6 +8,9 @@
 //
 #pragma once
 
+#include <tuple>
+#include <type_traits>
+
 namespace jsbind
 {
 namespace internal
@@ -0,0 +1,153 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace jsbind
+{
+
+/// Histogram of values in power of two buckets.
+/// Recording and taking snapshots are lock free, so any thread can read the histogram
+/// while another one records to it. Bucket `i` holds the values in [2^(i-1), 2^i),
+/// bucket 0 holds zeroes and the last bucket holds everything above.
+class histogram
+{
+public:
+    static const size_t num_buckets = 64;
+
+    struct snapshot
+    {
+        uint64_t buckets[num_buckets];
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+
+        double mean() const
+        {
+            return count ? double(sum) / double(count) : 0;
+        }
+
+        // upper bound of the bucket containing the p-th percentile (p in [0, 1])
+        uint64_t percentile(double p) const
+        {
+            if (!count) return 0;
+
+            uint64_t rank = uint64_t(p * double(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < num_buckets; ++i)
+            {
+                seen += buckets[i];
+                if (seen >= rank)
+                {
+                    uint64_t bound = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+                    return bound < max ? bound : max;
+                }
+            }
+            return max;
+        }
+    };
+
+    histogram()
+    {
+        reset();
+    }
+
+    histogram(const histogram&) = delete;
+    histogram& operator=(const histogram&) = delete;
+
+    void record(uint64_t value)
+    {
+        m_buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+    }
+
+    // same as `record` for a histogram which only one thread records to, with no lock prefixed instructions
+    // other threads can take snapshots of it, but must not roll or reset it
+    void record_unshared(uint64_t value)
+    {
+        add(m_buckets[bucket_of(value)], 1);
+        add(m_count, 1);
+        add(m_sum, value);
+
+        if (value > m_max.load(std::memory_order_relaxed))
+        {
+            m_max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // the snapshot is not atomic as a whole, but all values recorded before the call are in it
+    snapshot get() const
+    {
+        snapshot ret;
+        for (size_t i = 0; i < num_buckets; ++i)
+        {
+            ret.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        }
+        ret.count = m_count.load(std::memory_order_relaxed);
+        ret.sum = m_sum.load(std::memory_order_relaxed);
+        ret.max = m_max.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    // takes a snapshot and starts a new window
+    snapshot roll()
+    {
+        snapshot ret;
+        for (size_t i = 0; i < num_buckets; ++i)
+        {
+            ret.buckets[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+        }
+        ret.count = m_count.exchange(0, std::memory_order_relaxed);
+        ret.sum = m_sum.exchange(0, std::memory_order_relaxed);
+        ret.max = m_max.exchange(0, std::memory_order_relaxed);
+        return ret;
+    }
+
+    void reset()
+    {
+        for (auto& b : m_buckets)
+        {
+            b.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucket_of(uint64_t value)
+    {
+        size_t bucket = 0;
+        while (value)
+        {
+            ++bucket;
+            value >>= 1;
+        }
+        return bucket < num_buckets ? bucket : num_buckets - 1;
+    }
+
+private:
+    static void add(std::atomic<uint64_t>& a, uint64_t value)
+    {
+        a.store(a.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_buckets[num_buckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+}
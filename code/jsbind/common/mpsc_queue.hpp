@@ -0,0 +1,186 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <memory>
+
+namespace jsbind
+{
+namespace internal
+{
+
+// bounded lock-free queue with many producers and a single consumer
+// the slots are allocated once and reused, so items which hold memory (like strings)
+// keep it between pushes and the queue doesn't allocate once it's warm
+// each slot has a sequence number which tells whose turn it is to use the slot
+template <typename T>
+class mpsc_queue
+{
+public:
+    // capacity must be a power of two
+    explicit mpsc_queue(size_t capacity)
+        : m_slots(new slot[capacity])
+        , m_mask(capacity - 1)
+    {
+        m_head.value.store(0, std::memory_order_relaxed);
+        m_tail.value.store(0, std::memory_order_relaxed);
+        assert(capacity && (capacity & m_mask) == 0 && "mpsc_queue: capacity must be a power of two");
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // calls write(T&) on a free slot
+    // returns false without calling it if the queue is full
+    template <typename Write>
+    bool try_push(Write&& write)
+    {
+        size_t pos = m_tail.value.load(std::memory_order_relaxed);
+        slot* s;
+        for (;;)
+        {
+            s = &m_slots[pos & m_mask];
+            size_t seq = s->seq.load(std::memory_order_acquire);
+            auto diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0)
+            {
+                if (m_tail.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return false; // the consumer hasn't freed the slot yet
+            }
+            else
+            {
+                pos = m_tail.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        write(s->value);
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // calls read(T&) on the oldest item
+    // returns false if the queue is empty
+    // must only be called by the consumer thread
+    template <typename Read>
+    bool try_pop(Read&& read)
+    {
+        size_t pos = m_head.value.load(std::memory_order_relaxed);
+        auto& s = m_slots[pos & m_mask];
+        if (s.seq.load(std::memory_order_acquire) != pos + 1)
+        {
+            return false;
+        }
+
+        read(s.value);
+        m_head.value.store(pos + 1, std::memory_order_relaxed);
+        s.seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // an approximation when called concurrently with push or pop
+    bool empty() const
+    {
+        return m_head.value.load(std::memory_order_acquire) == m_tail.value.load(std::memory_order_acquire);
+    }
+
+private:
+    struct slot
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    // preceded by the rest of a cache line, so that consecutive ones are on separate lines
+    // padded rather than aligned, as new doesn't honor alignas above the default before c++17
+    struct padded_index
+    {
+        char pad[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> value;
+    };
+
+    std::unique_ptr<slot[]> m_slots;
+    const size_t m_mask;
+
+    // on separate cache lines, as the producers write to one and the consumer to the other
+    padded_index m_head;
+    padded_index m_tail;
+};
+
+// unbounded lock-free queue with many producers and a single consumer
+// a push is one allocation and one atomic exchange
+// the consumer owns the node of the last popped item (or the initial one) and
+// frees it when the next item is popped
+template <typename T>
+class mpsc_list
+{
+public:
+    mpsc_list()
+    {
+        auto stub = new node;
+        m_head.store(stub, std::memory_order_relaxed);
+        m_tail = stub;
+    }
+
+    mpsc_list(const mpsc_list&) = delete;
+    mpsc_list& operator=(const mpsc_list&) = delete;
+
+    ~mpsc_list()
+    {
+        T item;
+        while (try_pop(item));
+        delete m_tail;
+    }
+
+    void push(T value)
+    {
+        auto n = new node;
+        n->value = std::move(value);
+        auto prev = m_head.exchange(n, std::memory_order_acq_rel);
+        // until this store the consumer sees the queue as ending at prev
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // must only be called by the consumer thread
+    bool try_pop(T& out)
+    {
+        auto next = m_tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        out = std::move(next->value);
+        delete m_tail;
+        m_tail = next;
+        return true;
+    }
+
+private:
+    struct node
+    {
+        std::atomic<node*> next{ nullptr };
+        T value;
+    };
+
+    std::atomic<node*> m_head; // the last pushed node
+    node* m_tail; // the node before the next item
+};
+
+}
+}
@@ -0,0 +1,64 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace jsbind
+{
+namespace internal
+{
+
+// fair lock: threads get it in the order they asked for it
+// the waiters yield for a while and then sleep, as the lock may be held for long
+class ticket_lock
+{
+public:
+    ticket_lock() : m_next(0), m_serving(0) {}
+
+    ticket_lock(const ticket_lock&) = delete;
+    ticket_lock& operator=(const ticket_lock&) = delete;
+
+    void lock()
+    {
+        auto ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+        for (int spins = 0; m_serving.load(std::memory_order_acquire) != ticket; ++spins)
+        {
+            if (spins < 100)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    void unlock()
+    {
+        m_serving.fetch_add(1, std::memory_order_release);
+    }
+
+    // number of threads which hold or wait for the lock
+    uint32_t queue_length() const
+    {
+        return m_next.load(std::memory_order_relaxed) - m_serving.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> m_next;
+    std::atomic<uint32_t> m_serving;
+};
+
+}
+}
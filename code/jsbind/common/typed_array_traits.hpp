@@ -0,0 +1,103 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <type_traits>
+#include <cstddef>
+
+namespace jsbind
+{
+namespace internal
+{
+
+    enum class typed_array_type
+    {
+        none, // no typed array can view this type
+        int8,
+        uint8,
+        int16,
+        uint16,
+        int32,
+        uint32,
+        float32,
+        float64,
+    };
+
+    template <typename T, typename Enable = void>
+    struct typed_array_traits
+    {
+        static const typed_array_type type = typed_array_type::none;
+    };
+
+    template <typename T>
+    struct typed_array_traits<T, typename std::enable_if<std::is_integral<T>::value
+        && !std::is_same<T, bool>::value && sizeof(T) <= 4>::type>
+    {
+        static const typed_array_type type =
+            sizeof(T) == 1 ? (std::is_signed<T>::value ? typed_array_type::int8 : typed_array_type::uint8) :
+            sizeof(T) == 2 ? (std::is_signed<T>::value ? typed_array_type::int16 : typed_array_type::uint16) :
+            (std::is_signed<T>::value ? typed_array_type::int32 : typed_array_type::uint32);
+    };
+
+    template <>
+    struct typed_array_traits<float>
+    {
+        static const typed_array_type type = typed_array_type::float32;
+    };
+
+    template <>
+    struct typed_array_traits<double>
+    {
+        static const typed_array_type type = typed_array_type::float64;
+    };
+
+    template <typename T>
+    struct has_typed_array : std::integral_constant<bool,
+        typed_array_traits<T>::type != typed_array_type::none> {};
+
+    // name of the js constructor for the type
+    inline const char* typed_array_name(typed_array_type type)
+    {
+        switch (type)
+        {
+        case typed_array_type::int8: return "Int8Array";
+        case typed_array_type::uint8: return "Uint8Array";
+        case typed_array_type::int16: return "Int16Array";
+        case typed_array_type::uint16: return "Uint16Array";
+        case typed_array_type::int32: return "Int32Array";
+        case typed_array_type::uint32: return "Uint32Array";
+        case typed_array_type::float32: return "Float32Array";
+        case typed_array_type::float64: return "Float64Array";
+        default: return nullptr;
+        }
+    }
+
+    inline size_t typed_array_element_size(typed_array_type type)
+    {
+        switch (type)
+        {
+        case typed_array_type::int8:
+        case typed_array_type::uint8:
+            return 1;
+        case typed_array_type::int16:
+        case typed_array_type::uint16:
+            return 2;
+        case typed_array_type::int32:
+        case typed_array_type::uint32:
+        case typed_array_type::float32:
+            return 4;
+        case typed_array_type::float64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+}
+}
@@ -20,6 +20,15 @@ namespace
 class default_console : public console
 {
 public:
+    virtual bool is_enabled(console::msg_type type) const override
+    {
+#if defined(NDEBUG)
+        return type != msg_debug;
+#else
+        return true;
+#endif
+    }
+
     virtual void msg(console::msg_type type, const char* msg) override
     {
         switch (type)
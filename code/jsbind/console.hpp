@@ -25,6 +25,11 @@ public:
         msg_debug,
         msg_assert,
     };
+
+    // checked before the arguments of a message are converted to a string,
+    // so disabled messages cost nothing but the call
+    virtual bool is_enabled(msg_type) const { return true; }
+
     virtual void msg(msg_type type, const char* msg) = 0;
 };
 
@@ -0,0 +1,77 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#if defined(JSBIND_JSC)
+
+#include <JavaScriptCore/JavaScript.h>
+
+namespace jsbind
+{
+
+/// An additional js context which shares the VM (the JSC context group) of the main one.
+///
+/// Each context has its own global object, with its own `console` and `Module`. The
+/// bindings are registered once by `initialize` and installed into every new context,
+/// so creating a context is much cheaper than creating a new VM.
+///
+/// While a context is entered all jsbind calls (running scripts, creating and converting
+/// values) go to it. Values can be passed between contexts, but they keep the prototypes
+/// of the context which created them. The lazily created helpers of jsbind (such as the
+/// class of `packed_array`) belong to the context in which they were first used.
+///
+/// Contexts can only be created between `initialize` and `deinitialize` and must be destroyed
+/// before the latter. As the bindings are installed when a context is created, on JavaScriptCore
+/// `function` and `class_` may only be called from `JSBIND_BINDINGS`, never after `initialize`.
+/// Only JavaScriptCore supports contexts.
+class context
+{
+public:
+    context();
+    ~context();
+
+    context(const context&) = delete;
+    context& operator=(const context&) = delete;
+
+    /// Makes this the current context. Contexts can be nested, but a context can't be
+    /// entered again before it's exited.
+    void enter();
+
+    /// Makes the previous context current again.
+    void exit();
+
+private:
+    JSGlobalContextRef m_context;
+    JSGlobalContextRef m_previous;
+};
+
+class context_scope
+{
+public:
+    explicit context_scope(context& c)
+        : m_context(c)
+    {
+        m_context.enter();
+    }
+
+    ~context_scope()
+    {
+        m_context.exit();
+    }
+
+    context_scope(const context_scope&) = delete;
+    context_scope& operator=(const context_scope&) = delete;
+
+private:
+    context& m_context;
+};
+
+}
+
+#endif
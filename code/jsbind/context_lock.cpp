@@ -0,0 +1,27 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "context_lock.hpp"
+
+namespace jsbind
+{
+
+// v8 implements these in v8/jsbind.cpp
+#if !defined(JSBIND_V8)
+context_lock_stats get_context_lock_stats(bool)
+{
+    context_lock_stats ret = {};
+    return ret;
+}
+
+void set_fair_context_lock(bool)
+{
+}
+#endif
+
+}
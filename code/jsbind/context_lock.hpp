@@ -0,0 +1,37 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "jsbind/common/histogram.hpp"
+
+#include <cstdint>
+
+namespace jsbind
+{
+
+/// Locking of the isolate by `enter_context` and `exit_context`, for threads which share it.
+/// Only v8 locks (node manages the isolate itself), so elsewhere the stats are zero.
+struct context_lock_stats
+{
+    histogram::snapshot wait_ns; // time to acquire the isolate
+    histogram::snapshot hold_ns; // time between entering and exiting the context
+    uint64_t acquisitions;
+    uint64_t contended; // acquisitions which found the isolate held by another thread (approximate)
+};
+
+/// Can be called from any thread.
+/// The histograms are of the acquisitions since initialization or since the last rolled snapshot.
+extern context_lock_stats get_context_lock_stats(bool roll = false);
+
+/// With a fair lock the threads which call `enter_context` get the isolate in the order they
+/// called it. Without it (the default) the order is up to the OS and a thread which enters in
+/// a loop may starve the others. Set it while no thread is in the context.
+extern void set_fair_context_lock(bool fair);
+
+}
@@ -10,6 +10,10 @@
 
 #include <iostream>
 
+#if defined(JSBIND_V8)
+#   include "jsbind/v8/global.hpp"
+#endif
+
 namespace jsbind
 {
 
@@ -32,6 +36,9 @@ class default_exception_handler : public exception_handler
 
 exception_handler* g_exception_handler = nullptr;
 
+int g_stack_depth = 10;
+bool g_stack_depth_set = false;
+
 }
 
 void set_exception_handler(exception_handler* handler)
@@ -49,4 +56,35 @@ void set_default_exception_handler()
     set_exception_handler(&g_default_exception_handler);
 }
 
-}
\ No newline at end of file
+void set_exception_stack_depth(int depth)
+{
+    g_stack_depth = depth;
+    g_stack_depth_set = true;
+
+#if defined(JSBIND_V8)
+    if (internal::isolate)
+    {
+        internal::isolate->SetCaptureStackTraceForUncaughtExceptions(depth > 0, depth);
+    }
+#endif
+}
+
+int get_exception_stack_depth()
+{
+    return g_stack_depth;
+}
+
+#if defined(JSBIND_V8)
+namespace internal
+{
+    void init_exception_stack_depth(bool own_isolate)
+    {
+        if (own_isolate || g_stack_depth_set)
+        {
+            isolate->SetCaptureStackTraceForUncaughtExceptions(g_stack_depth > 0, g_stack_depth);
+        }
+    }
+}
+#endif
+
+}
@@ -8,19 +8,81 @@
 //
 #pragma once
 
+#include <string>
+#include <vector>
+
 namespace jsbind
 {
 
+struct stack_frame
+{
+    std::string function; // empty for anonymous functions
+    std::string resource; // the script name or url
+    int line;   // 1-based, 0 if unknown
+    int column; // 1-based, 0 if unknown
+};
+
+/// A js exception reported to the exception handler.
+/// The parts are read from the engine only when asked for, so a handler which needs
+/// a few of them (or just counts exceptions) doesn't pay for formatting the rest.
+/// The object is valid only during the call to the handler.
+class exception_info
+{
+public:
+    /// The exception converted to a string.
+    virtual std::string message() const = 0;
+
+    /// Name of the script where the exception was thrown.
+    virtual std::string resource() const = 0;
+
+    /// 1-based, 0 if unknown.
+    virtual int line() const = 0;
+
+    /// Range of the source line where the exception was thrown (0-based, end excluded).
+    virtual int start_column() const = 0;
+    virtual int end_column() const = 0;
+
+    /// Empty if the engine doesn't provide it.
+    virtual std::string source_line() const = 0;
+
+    /// The stack when the exception was thrown, innermost frame first.
+    /// Up to `get_exception_stack_depth()` frames, empty if the engine doesn't provide them.
+    virtual std::vector<stack_frame> frames() const = 0;
+
+    /// Everything formatted into a multi-line text, as `exception_handler::on_exception` receives it.
+    virtual std::string text() const = 0;
+
+protected:
+    ~exception_info() {}
+};
+
 class exception_handler
 {
 public:
     virtual ~exception_handler() {}
     virtual void on_exception(const char* exception) = 0;
+
+    // fatal errors of the engine and the termination at the heap limit
+    // the latter is reported from inside the engine's gc, so it must not touch js values
     virtual void on_engine_error(const char* error) = 0;
+
+    // called for js exceptions
+    // override it to use the parts of the exception instead of the formatted text
+    virtual void on_exception_info(const exception_info& info)
+    {
+        on_exception(info.text().c_str());
+    }
 };
 
 extern void set_exception_handler(exception_handler* handler);
 extern exception_handler* get_exception_handler();
 extern void set_default_exception_handler();
 
+/// Maximum number of stack frames in `exception_info::frames` (10 by default).
+/// On v8 the stack is captured when an exception is thrown and not caught in js,
+/// which has a cost. 0 turns it off. On node the capture is left as node set it up,
+/// unless the depth is set explicitly.
+extern void set_exception_stack_depth(int depth);
+extern int get_exception_stack_depth();
+
 }
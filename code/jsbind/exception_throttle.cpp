@@ -0,0 +1,162 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "exception_throttle.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace jsbind
+{
+
+namespace
+{
+std::chrono::steady_clock::duration seconds(double s)
+{
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(s));
+}
+}
+
+throttled_exception_handler::throttled_exception_handler(exception_handler& target, const exception_throttle_config& config)
+    : m_target(target)
+    , m_config(config)
+    , m_tokens(config.burst)
+    , m_last_refill(clock::now())
+    , m_last_summary(m_last_refill)
+{}
+
+void throttled_exception_handler::on_exception(const char* exception)
+{
+    // already formatted text has no parts, so the text itself is the fingerprint
+    auto now = clock::now();
+    if (admit({ std::string(), 0, exception }, now))
+    {
+        m_target.on_exception(exception);
+    }
+    maybe_summarize(now);
+}
+
+void throttled_exception_handler::on_engine_error(const char* error)
+{
+    m_target.on_engine_error(error);
+}
+
+void throttled_exception_handler::on_exception_info(const exception_info& info)
+{
+    auto now = clock::now();
+    if (admit({ info.resource(), info.line(), info.message() }, now))
+    {
+        m_target.on_exception_info(info);
+    }
+    maybe_summarize(now);
+}
+
+bool throttled_exception_handler::admit(fingerprint&& fp, clock::time_point now)
+{
+    auto found = m_entries.find(fp);
+    if (found != m_entries.end())
+    {
+        auto& e = found->second;
+        if (now - e.last_passed < seconds(m_config.dedup_window_seconds) || !take_token(now))
+        {
+            ++e.suppressed;
+            ++m_suppressed;
+            return false;
+        }
+
+        e.last_passed = now;
+        return true;
+    }
+
+    if (!take_token(now))
+    {
+        ++m_untracked_suppressed;
+        ++m_suppressed;
+        return false;
+    }
+
+    if (m_entries.size() >= m_config.max_tracked)
+    {
+        evict(now);
+    }
+
+    if (m_entries.size() < m_config.max_tracked)
+    {
+        m_entries[std::move(fp)].last_passed = now;
+    }
+
+    return true;
+}
+
+bool throttled_exception_handler::take_token(clock::time_point now)
+{
+    double elapsed = std::chrono::duration<double>(now - m_last_refill).count();
+    m_tokens = std::min(m_config.burst, m_tokens + elapsed * m_config.reports_per_second);
+    m_last_refill = now;
+
+    if (m_tokens < 1) return false;
+
+    m_tokens -= 1;
+    return true;
+}
+
+void throttled_exception_handler::evict(clock::time_point now)
+{
+    // entries with nothing to summarize whose window is over are the same as new ones
+    for (auto i = m_entries.begin(); i != m_entries.end(); )
+    {
+        if (!i->second.suppressed && now - i->second.last_passed >= seconds(m_config.dedup_window_seconds))
+        {
+            i = m_entries.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void throttled_exception_handler::maybe_summarize(clock::time_point now)
+{
+    if (now - m_last_summary >= seconds(m_config.summary_interval_seconds))
+    {
+        flush_summary();
+    }
+}
+
+void throttled_exception_handler::flush_summary()
+{
+    m_last_summary = clock::now();
+
+    for (auto& e : m_entries)
+    {
+        if (!e.second.suppressed) continue;
+
+        std::ostringstream sout;
+        sout << "jsbind: " << e.second.suppressed << " more of: ";
+        if (!e.first.resource.empty())
+        {
+            sout << e.first.resource << ":" << e.first.line << ": ";
+        }
+        sout << e.first.message;
+        m_target.on_exception(sout.str().c_str());
+
+        e.second.suppressed = 0;
+    }
+
+    if (m_untracked_suppressed)
+    {
+        std::ostringstream sout;
+        sout << "jsbind: " << m_untracked_suppressed << " more exceptions over the rate limit";
+        m_target.on_exception(sout.str().c_str());
+
+        m_untracked_suppressed = 0;
+    }
+}
+
+}
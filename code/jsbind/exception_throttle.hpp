@@ -0,0 +1,113 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "exception.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace jsbind
+{
+
+struct exception_throttle_config
+{
+    // repeats of an exception (same script, line and message) within the window are only counted
+    double dedup_window_seconds = 10;
+
+    // token bucket for all reports: the sustained rate and the size of a burst
+    double reports_per_second = 10;
+    double burst = 20;
+
+    // how often the counts of suppressed exceptions are reported
+    double summary_interval_seconds = 60;
+
+    // exceptions which aren't tracked any more are only rate limited
+    size_t max_tracked = 1024;
+};
+
+/// Exception handler which stops error storms from reaching another handler.
+///
+///     static jsbind::throttled_exception_handler handler(my_handler);
+///     jsbind::set_exception_handler(&handler);
+///
+/// Exceptions are fingerprinted by script, line and message. The first one of a kind is passed
+/// on and its repeats within the dedup window are counted instead. All reports are also rate
+/// limited. Every summary interval the target receives the counts of the suppressed exceptions
+/// through `on_exception`, like "jsbind: 1234 more of: script.js:12: TypeError: ...".
+/// The summary is checked on each exception, or can be emitted with `flush_summary`.
+/// Engine errors are always passed on.
+class throttled_exception_handler : public exception_handler
+{
+public:
+    explicit throttled_exception_handler(exception_handler& target,
+        const exception_throttle_config& config = exception_throttle_config());
+
+    virtual void on_exception(const char* exception) override;
+    virtual void on_engine_error(const char* error) override;
+    virtual void on_exception_info(const exception_info& info) override;
+
+    /// Reports the counts of suppressed exceptions now.
+    void flush_summary();
+
+    /// Total number of exceptions which were not passed on.
+    uint64_t suppressed() const { return m_suppressed; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct fingerprint
+    {
+        std::string resource;
+        int line;
+        std::string message;
+
+        bool operator==(const fingerprint& other) const
+        {
+            return line == other.line && message == other.message && resource == other.resource;
+        }
+    };
+
+    struct fingerprint_hash
+    {
+        size_t operator()(const fingerprint& f) const
+        {
+            std::hash<std::string> h;
+            return h(f.resource) ^ (h(f.message) * 31) ^ size_t(f.line);
+        }
+    };
+
+    struct entry
+    {
+        clock::time_point last_passed;
+        uint64_t suppressed = 0; // since the last summary
+    };
+
+    // returns true if the exception should be passed on
+    bool admit(fingerprint&& fp, clock::time_point now);
+    bool take_token(clock::time_point now);
+    void evict(clock::time_point now);
+    void maybe_summarize(clock::time_point now);
+
+    exception_handler& m_target;
+    exception_throttle_config m_config;
+
+    std::unordered_map<fingerprint, entry, fingerprint_hash> m_entries;
+
+    double m_tokens;
+    clock::time_point m_last_refill;
+    clock::time_point m_last_summary;
+    uint64_t m_untracked_suppressed = 0; // since the last summary
+    uint64_t m_suppressed = 0;
+};
+
+}
@@ -0,0 +1,117 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "gc.hpp"
+
+#if defined(JSBIND_V8)
+#   include "jsbind/v8/global.hpp"
+#endif
+
+#include <atomic>
+
+namespace jsbind
+{
+
+namespace
+{
+gc_observer* g_gc_observer = nullptr;
+
+histogram g_pauses[gc_num_types];
+std::atomic<uint64_t> g_bytes_freed(0);
+
+heap_limits g_heap_limits = {};
+heap_limit_handler* g_heap_limit_handler = nullptr;
+bool g_above_soft_limit = false;
+}
+
+void set_gc_observer(gc_observer* observer)
+{
+    g_gc_observer = observer;
+}
+
+gc_observer* get_gc_observer()
+{
+    return g_gc_observer;
+}
+
+gc_stats get_gc_stats(bool roll)
+{
+    gc_stats ret;
+    for (int i = 0; i < gc_num_types; ++i)
+    {
+        ret.pauses_us[i] = roll ? g_pauses[i].roll() : g_pauses[i].get();
+    }
+    ret.bytes_freed = roll ? g_bytes_freed.exchange(0, std::memory_order_relaxed) : g_bytes_freed.load(std::memory_order_relaxed);
+    return ret;
+}
+
+void set_heap_limits(const heap_limits& limits)
+{
+    g_heap_limits = limits;
+    g_above_soft_limit = false;
+#if defined(JSBIND_V8)
+    internal::update_near_heap_limit_callback();
+#endif
+}
+
+const heap_limits& get_heap_limits()
+{
+    return g_heap_limits;
+}
+
+void set_heap_limit_handler(heap_limit_handler* handler)
+{
+    g_heap_limit_handler = handler;
+#if defined(JSBIND_V8)
+    internal::update_near_heap_limit_callback();
+#endif
+}
+
+heap_limit_handler* get_heap_limit_handler()
+{
+    return g_heap_limit_handler;
+}
+
+#if !defined(JSBIND_V8)
+heap_stats get_heap_stats()
+{
+    heap_stats ret = {};
+    return ret;
+}
+#endif
+
+namespace internal
+{
+
+void record_gc(const gc_event& e)
+{
+    g_pauses[e.type].record(e.duration_us);
+    if (e.bytes_freed > 0)
+    {
+        g_bytes_freed.fetch_add(uint64_t(e.bytes_freed), std::memory_order_relaxed);
+    }
+
+    if (g_gc_observer)
+    {
+        g_gc_observer->on_gc(e);
+    }
+
+    if (g_heap_limits.soft_limit && e.type == gc_mark_compact)
+    {
+        bool above = e.used_heap_size > g_heap_limits.soft_limit;
+        if (above && !g_above_soft_limit && g_heap_limit_handler)
+        {
+            g_heap_limit_handler->on_soft_limit(e.used_heap_size);
+        }
+        g_above_soft_limit = above;
+    }
+}
+
+}
+
+}
@@ -0,0 +1,125 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "jsbind/common/histogram.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace jsbind
+{
+
+enum gc_type
+{
+    gc_scavenge,
+    gc_mark_compact,
+    gc_incremental_marking,
+    gc_weak_callbacks,
+    gc_other,
+
+    gc_num_types
+};
+
+struct gc_event
+{
+    gc_type type;
+    uint64_t duration_us; // pause time
+    int64_t bytes_freed; // change of the used heap size (negative if it grew)
+    size_t used_heap_size; // after the collection
+};
+
+/// Notified of every garbage collection.
+/// `on_gc` is called in the engine's gc epilogue, so it must not touch js values.
+class gc_observer
+{
+public:
+    virtual ~gc_observer() {}
+    virtual void on_gc(const gc_event& e) = 0;
+};
+
+extern void set_gc_observer(gc_observer* observer);
+extern gc_observer* get_gc_observer();
+
+struct gc_stats
+{
+    histogram::snapshot pauses_us[gc_num_types];
+    uint64_t bytes_freed;
+};
+
+/// Pause time histograms of the collections since initialization or since the last rolled snapshot.
+/// Can be called from any thread.
+extern gc_stats get_gc_stats(bool roll = false);
+
+struct heap_stats
+{
+    size_t total_heap_size;
+    size_t used_heap_size;
+    size_t heap_size_limit;
+    size_t malloced_memory;
+    size_t external_memory;
+};
+
+/// Current heap statistics. Must be called in the context.
+/// Only v8 reports gc events and heap statistics. Elsewhere there are no events and the statistics are zero.
+extern heap_stats get_heap_stats();
+
+/// Memory limits of the js heap. Zero means the engine's default.
+struct heap_limits
+{
+    size_t max_young_generation_size; // bytes of the nursery, where new objects are allocated
+    size_t max_old_generation_size; // bytes of the rest of the heap
+
+    // used heap size above which `heap_limit_handler::on_soft_limit` is called after a mark_compact collection
+    size_t soft_limit;
+};
+
+/// Sets the limits of the heap. Only v8 supports them.
+/// The generation sizes are applied when `initialize` creates the isolate, so they must be set before it.
+/// They're ignored on node, which creates the isolate (use its --max-old-space-size instead).
+/// The soft limit can be changed at any time, but after initialization only in the context.
+extern void set_heap_limits(const heap_limits& limits);
+extern const heap_limits& get_heap_limits();
+
+/// Reacts to a heap which is running out of memory.
+class heap_limit_handler
+{
+public:
+    virtual ~heap_limit_handler() {}
+
+    enum action
+    {
+        shed,      // the handler released memory, keep running
+        terminate, // terminate the running js
+    };
+
+    /// Called by v8 when the heap is close to its hard limit, instead of failing with out of memory.
+    /// The limit is raised temporarily for the memory to be released or the js to be unwound,
+    /// and restored when the heap shrinks. The handler gets a single raise of a quarter of the
+    /// initial limit: if the heap reaches the limit again before it shrinks, the js is terminated
+    /// without asking. Called in the engine's gc, so it must not touch js values.
+    /// Without a handler the running js is terminated if limits are set, and otherwise v8 fails
+    /// with out of memory as usual (on node the limits don't count, only a handler does).
+    virtual action on_near_heap_limit(size_t heap_limit) = 0;
+
+    /// Called after a mark_compact collection when the used heap size crosses above the soft limit.
+    /// It's called again only after the heap drops below it.
+    virtual void on_soft_limit(size_t used_heap_size) {}
+};
+
+/// After initialization it must be called in the context.
+extern void set_heap_limit_handler(heap_limit_handler* handler);
+extern heap_limit_handler* get_heap_limit_handler();
+
+namespace internal
+{
+    extern void record_gc(const gc_event& e);
+}
+
+}
@@ -0,0 +1,239 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "heap_snapshot.hpp"
+
+#include <ostream>
+#include <algorithm>
+
+#if defined(JSBIND_V8)
+#   include "jsbind/v8/global.hpp"
+#   include <v8-profiler.h>
+#   include <cstdio>
+#endif
+
+namespace jsbind
+{
+
+#if defined(JSBIND_V8)
+
+using namespace internal;
+
+namespace
+{
+
+class file_output_stream : public v8::OutputStream
+{
+public:
+    explicit file_output_stream(FILE* f)
+        : m_file(f)
+    {}
+
+    virtual void EndOfStream() override {}
+
+    virtual int GetChunkSize() override
+    {
+        return 64 * 1024;
+    }
+
+    virtual WriteResult WriteAsciiChunk(char* data, int size) override
+    {
+        if (fwrite(data, 1, size_t(size), m_file) != size_t(size))
+        {
+            m_failed = true;
+            return kAbort;
+        }
+        return kContinue;
+    }
+
+    bool failed() const { return m_failed; }
+
+private:
+    FILE* m_file;
+    bool m_failed = false;
+};
+
+const v8::HeapSnapshot* take_snapshot()
+{
+    return isolate->GetHeapProfiler()->TakeHeapSnapshot();
+}
+
+void delete_snapshot(const v8::HeapSnapshot* snapshot)
+{
+    const_cast<v8::HeapSnapshot*>(snapshot)->Delete();
+}
+
+std::string constructor_of(const v8::HeapGraphNode* node)
+{
+    switch (node->GetType())
+    {
+    case v8::HeapGraphNode::kObject:
+    {
+        v8::String::Utf8Value name(isolate, node->GetName());
+        return std::string(*name, name.length());
+    }
+    case v8::HeapGraphNode::kClosure:
+    {
+        // functions are named as themselves, which would put a constructor with its instances
+        v8::String::Utf8Value name(isolate, node->GetName());
+        return "(closure) " + std::string(*name, name.length());
+    }
+    case v8::HeapGraphNode::kArray: return "(array)";
+    case v8::HeapGraphNode::kString:
+    case v8::HeapGraphNode::kConsString:
+    case v8::HeapGraphNode::kSlicedString: return "(string)";
+    case v8::HeapGraphNode::kCode: return "(code)";
+    case v8::HeapGraphNode::kRegExp: return "(regexp)";
+    case v8::HeapGraphNode::kHeapNumber: return "(number)";
+    case v8::HeapGraphNode::kSymbol: return "(symbol)";
+    case v8::HeapGraphNode::kBigInt: return "(bigint)";
+    case v8::HeapGraphNode::kNative: return "(native)";
+    case v8::HeapGraphNode::kSynthetic: return "(synthetic)";
+    default: return "(hidden)";
+    }
+}
+
+}
+
+bool write_heap_snapshot(const char* path)
+{
+    auto f = fopen(path, "wb");
+    if (!f) return false;
+
+    v8::HandleScope scope(isolate);
+    auto snapshot = take_snapshot();
+
+    file_output_stream stream(f);
+    snapshot->Serialize(&stream, v8::HeapSnapshot::kJSON);
+    delete_snapshot(snapshot);
+
+    bool ok = !stream.failed();
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+heap_summary take_heap_summary()
+{
+    heap_summary ret;
+
+    v8::HandleScope scope(isolate);
+    auto snapshot = take_snapshot();
+
+    const int num_nodes = snapshot->GetNodesCount();
+
+    // constructor names of the nodes by node id
+    std::map<v8::SnapshotObjectId, const std::string*> node_constructors;
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        auto node = snapshot->GetNode(i);
+        auto c = ret.constructors.emplace(constructor_of(node), heap_summary::entry()).first;
+        ++c->second.count;
+        c->second.self_size += node->GetShallowSize();
+        node_constructors[node->GetId()] = &c->first;
+    }
+
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        auto node = snapshot->GetNode(i);
+        auto& from = *node_constructors[node->GetId()];
+
+        const int num_edges = node->GetChildrenCount();
+        for (int e = 0; e < num_edges; ++e)
+        {
+            auto edge = node->GetChild(e);
+            auto type = edge->GetType();
+            if (type == v8::HeapGraphEdge::kWeak || type == v8::HeapGraphEdge::kShortcut) continue;
+
+            auto& to = *node_constructors[edge->GetToNode()->GetId()];
+            if (&to == &from) continue;
+
+            ++ret.constructors[to].retainers[from];
+        }
+    }
+
+    delete_snapshot(snapshot);
+    return ret;
+}
+
+#else
+
+bool write_heap_snapshot(const char*)
+{
+    return false;
+}
+
+heap_summary take_heap_summary()
+{
+    return heap_summary();
+}
+
+#endif
+
+std::vector<heap_growth> diff_heap_summaries(const heap_summary& before, const heap_summary& after,
+    size_t max_constructors, size_t max_retainers)
+{
+    static const heap_summary::entry none;
+
+    std::vector<heap_growth> ret;
+    for (auto& c : after.constructors)
+    {
+        auto b = before.constructors.find(c.first);
+        auto& old = b == before.constructors.end() ? none : b->second;
+
+        heap_growth g;
+        g.constructor = c.first;
+        g.count = int64_t(c.second.count) - int64_t(old.count);
+        g.self_size = int64_t(c.second.self_size) - int64_t(old.self_size);
+        if (g.self_size <= 0 && g.count <= 0) continue;
+
+        for (auto& r : c.second.retainers)
+        {
+            auto br = old.retainers.find(r.first);
+            int64_t delta = int64_t(r.second) - (br == old.retainers.end() ? 0 : int64_t(br->second));
+            if (delta > 0)
+            {
+                g.retainers.emplace_back(r.first, delta);
+            }
+        }
+
+        std::sort(g.retainers.begin(), g.retainers.end(), [](const std::pair<std::string, int64_t>& a, const std::pair<std::string, int64_t>& b) {
+            return a.second > b.second;
+        });
+        if (g.retainers.size() > max_retainers)
+        {
+            g.retainers.resize(max_retainers);
+        }
+
+        ret.emplace_back(std::move(g));
+    }
+
+    std::sort(ret.begin(), ret.end(), [](const heap_growth& a, const heap_growth& b) {
+        return a.self_size > b.self_size;
+    });
+    if (ret.size() > max_constructors)
+    {
+        ret.resize(max_constructors);
+    }
+
+    return ret;
+}
+
+void write_heap_growth(std::ostream& out, const std::vector<heap_growth>& growth)
+{
+    for (auto& g : growth)
+    {
+        out << g.constructor << ": " << (g.count >= 0 ? "+" : "") << g.count << " objects, "
+            << (g.self_size >= 0 ? "+" : "") << g.self_size << " bytes\n";
+        for (auto& r : g.retainers)
+        {
+            out << "    retained by " << r.first << ": +" << r.second << '\n';
+        }
+    }
+}
+
+}
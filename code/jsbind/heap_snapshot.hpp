@@ -0,0 +1,60 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iosfwd>
+#include <cstdint>
+
+namespace jsbind
+{
+
+/// Writes a snapshot of the js heap in the .heapsnapshot format of Chrome DevTools (Memory > Load).
+/// The snapshot is streamed to the file. Must be called in the context.
+/// Returns false if the file couldn't be written or the engine has no heap profiler (only v8 has one).
+extern bool write_heap_snapshot(const char* path);
+
+/// The objects in the heap grouped by constructor.
+/// Objects which are not created by a constructor are grouped by their type, such as "(string)" or "(code)",
+/// and functions by their names, such as "(closure) update".
+struct heap_summary
+{
+    struct entry
+    {
+        uint64_t count = 0;
+        uint64_t self_size = 0;
+        std::map<std::string, uint64_t> retainers; // number of references from objects of other constructors
+    };
+
+    std::map<std::string, entry> constructors;
+};
+
+/// Takes a heap snapshot and summarizes it. Must be called in the context.
+/// Empty if the engine has no heap profiler.
+extern heap_summary take_heap_summary();
+
+/// Change of a constructor between two summaries.
+struct heap_growth
+{
+    std::string constructor;
+    int64_t count;
+    int64_t self_size;
+    std::vector<std::pair<std::string, int64_t>> retainers; // the retainers which grew most
+};
+
+/// The constructors which grew most (by self size) from `before` to `after`.
+/// Take a summary, let the app run, take another one and diff them to find what leaks and what holds it.
+extern std::vector<heap_growth> diff_heap_summaries(const heap_summary& before, const heap_summary& after,
+    size_t max_constructors = 20, size_t max_retainers = 5);
+
+extern void write_heap_growth(std::ostream& out, const std::vector<heap_growth>& growth);
+
+}
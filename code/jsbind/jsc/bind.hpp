@@ -11,32 +11,100 @@
 #include "value.hpp"
 #include "jsbind/common/ptr_cast.hpp"
 #include "jsbind/common/deinitializers.hpp"
+#include "jsbind/common/field_layout.hpp"
+
+#include <vector>
+#include <cassert>
 
 namespace jsbind
 {
 
 namespace internal
 {
+    // a registered function: the trampoline which calls its slot from a static function table
+    // or, when all trampolines are taken, the slot itself, which is put in a function object
+    struct registered_function
+    {
+        JSObjectCallAsFunctionCallback trampoline;
+        const static_function_slot* slot;
+    };
+
+    extern registered_function register_function(const static_function_slot& slot);
+
+    // functions of a class or of Module
+    // they are registered once and installed into each context as the static functions of a js class
+    // jsc creates the function objects lazily and the calls skip the private data of a function object
+    class function_table
+    {
+    public:
+        template <typename ReturnType, typename... Args>
+        void add(const char* class_name, const char* js_name, ReturnType(*func)(Args...))
+        {
+            static_function_slot slot;
+            slot.invoke = invoke_static_function<ReturnType, Args...>;
+            slot.func = ptr_cast<ReturnType(*)(Args...)>(func);
+#if defined(JSBIND_BINDING_STATS)
+            slot.stats_id = register_binding(binding_name(class_name, js_name));
+#else
+            (void)class_name;
+#endif
+
+            auto f = register_function(slot);
+            if (f.trampoline)
+            {
+                JSStaticFunction sf = { js_name, f.trampoline, kJSPropertyAttributeNone };
+                m_static_functions.push_back(sf);
+            }
+            else
+            {
+                function_object fo = { js_name, f.slot };
+                m_function_objects.push_back(fo);
+            }
+        }
+
+        // adds the functions to an object of a context
+        void install(JSContextRef ctx, JSObjectRef obj);
+
+        void clear();
+
+    private:
+        struct function_object
+        {
+            const char* name;
+            const static_function_slot* slot;
+        };
+
+        std::vector<JSStaticFunction> m_static_functions;
+        std::vector<function_object> m_function_objects;
+        JSClassRef m_class = nullptr; // created on the first install
+    };
+
+    struct class_binding
+    {
+        const char* name;
+        function_table functions;
+    };
+
     class class_data
     {
     public:
-        JSObjectRef m_jsc_func;
+        static function_table global_functions; // of Module
 
-        static JSObjectRef global;
+        static std::vector<class_binding> classes;
 
         static JSClassRef function_class;
+
+        // the bindings are installed into the contexts as they're created
+        // so they can only be registered before any context exists, from JSBIND_BINDINGS
+        static bool registering;
     };
 }
 
 template <typename ReturnType, typename... Args>
 void function(const char* js_name, ReturnType(*func)(Args...))
 {
-    auto func_data = new internal::call_class_function_from_jsc<ReturnType, Args...>(func);
-    auto js_func = JSObjectMake(internal::jsc_context, internal::class_data::function_class, func_data);
-
-    auto name = internal::to_jsc_string_copy(js_name);
-    JSObjectSetProperty(internal::jsc_context, internal::class_data::global, name, js_func, kJSPropertyAttributeNone, nullptr);
-    JSStringRelease(name);
+    assert(internal::class_data::registering && "jsc bindings can only be registered in JSBIND_BINDINGS");
+    internal::class_data::global_functions.add(nullptr, js_name, func);
 }
 
 template <typename T>
@@ -44,37 +112,24 @@ class class_ : private internal::class_data
 {
 public:
     class_(const char* js_name)
+        : m_index(classes.size())
     {
-        auto name = internal::to_jsc_string_copy(js_name);
-        //JSObjectMakeFunction(internal::jsc_context, name, 0, nullptr, nullptr, nullptr, 0, nullptr);
-        m_jsc_func = JSObjectMake(internal::jsc_context, nullptr, nullptr);
-        JSValueProtect(internal::jsc_context, m_jsc_func);
-
-        JSObjectSetProperty(internal::jsc_context, global, name, m_jsc_func, kJSPropertyAttributeNone, nullptr);
-
-        JSStringRelease(name);
-    }
-
-    ~class_()
-    {
-        JSValueUnprotect(internal::jsc_context, m_jsc_func);
+        assert(registering && "jsc bindings can only be registered in JSBIND_BINDINGS");
+        internal::class_binding b = { js_name, internal::function_table() };
+        classes.push_back(b);
     }
 
     template <typename ReturnType, typename... Args>
     class_& class_function(const char* js_name, ReturnType(*class_func)(Args...))
     {
-        auto func_data = new internal::call_class_function_from_jsc<ReturnType, Args...>(class_func);
-        auto js_func = JSObjectMake(internal::jsc_context, function_class, func_data);
-
-        auto name = internal::to_jsc_string_copy(js_name);
-        JSObjectSetProperty(internal::jsc_context, m_jsc_func, name, js_func, kJSPropertyAttributeNone, nullptr);
-        JSStringRelease(name);
-
+        assert(registering && "jsc bindings can only be registered in JSBIND_BINDINGS");
+        auto& c = classes[m_index];
+        c.functions.add(c.name, js_name, class_func);
         return *this;
     }
 
 private:
-
+    size_t m_index;
 };
 
 namespace internal
@@ -85,6 +140,7 @@ namespace internal
         void* pfield;
         void(*from_jsc)(JSValueRef value, void* obj, void* pfield);
         JSValueRef(*to_jsc)(const void* obj, void* pfield);
+        field_layout layout;
     };
 }
 
@@ -125,7 +181,8 @@ public:
             internal::to_jsc_string_copy(js_name),
             internal::ptr_cast<Field>(field),
             field_from_jsc<Field>,
-            field_to_jsc<Field>
+            field_to_jsc<Field>,
+            internal::make_field_layout<T>(js_name, field)
         };
         fields.push_back(f);
         return *this;
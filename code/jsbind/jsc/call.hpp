@@ -12,6 +12,9 @@
 #include "jsbind/error.hpp"
 #include "jsbind/common/index_sequence.hpp"
 #include "jsbind/common/function_traits.hpp"
+#include "jsbind/common/ptr_cast.hpp"
+#include "jsbind/binding_stats.hpp"
+#include "jsbind/watchdog.hpp"
 
 #include <tuple>
 
@@ -27,6 +30,7 @@ namespace internal
         // +1 so when there are zero args we at least have something
         JSValueRef jsc_args[num_args + 1] = { internal::to_jsc(args)... };
 
+        watchdog_scope watch(false);
         JSValueRef exception = nullptr;
         auto ret = JSObjectCallAsFunction(jsc_context, func, self, num_args, jsc_args, &exception);
 
@@ -54,36 +58,72 @@ namespace internal
         return JSValueMakeUndefined(jsc_context);
     }
 
-    struct function_private_data
+#if defined(JSBIND_BINDING_STATS)
+    // same as tuple_call, but the arguments are converted ahead, so that each part of the call can be timed
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<!is_void_return<Func>::value,
+        JSValueRef>::type timed_tuple_call(uint32_t stats_id, Func func, const JSValueRef args[], index_sequence<Seq...>)
     {
-        virtual ~function_private_data() {}
-        virtual JSValueRef call(JSObjectRef self, size_t numArgs, const JSValueRef args[]) = 0;
-    };
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::type...> converted{
+            from_jsc<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
 
-    template <typename ReturnType, typename... Args>
-    struct call_class_function_from_jsc : public function_private_data
+        auto&& result = func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
+
+        return to_jsc(result);
+    }
+
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<is_void_return<Func>::value,
+        JSValueRef>::type timed_tuple_call(uint32_t stats_id, Func func, const JSValueRef args[], index_sequence<Seq...>)
     {
-        call_class_function_from_jsc(ReturnType(*cxx_func)(Args...))
-            : m_cxx_func(cxx_func)
-        {}
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::type...> converted{
+            from_jsc<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
 
-        virtual JSValueRef call(JSObjectRef self, size_t numArgs, const JSValueRef args[]) override
-        {
-            JSBIND_JS_CHECK(numArgs >= sizeof...(Args), "Not enough arguments for function.");
+        func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
 
-            return tuple_call<std::tuple<Args...>>(m_cxx_func, args, make_index_sequence<sizeof...(Args)>());
-        }
+        return JSValueMakeUndefined(jsc_context);
+    }
+#endif
 
-        ReturnType(*m_cxx_func)(Args...);
+    // a bound function
+    // entries of static function tables can't carry data, so each one gets a trampoline which calls
+    // the slot of the same index, and functions without a trampoline keep the slot as private data
+    struct static_function_slot
+    {
+        JSValueRef(*invoke)(const static_function_slot& slot, size_t numArgs, const JSValueRef args[]);
+        void* func;
+#if defined(JSBIND_BINDING_STATS)
+        uint32_t stats_id;
+#endif
     };
 
+    template <typename ReturnType, typename... Args>
+    JSValueRef invoke_static_function(const static_function_slot& slot, size_t numArgs, const JSValueRef args[])
+    {
+        JSBIND_JS_CHECK(numArgs >= sizeof...(Args), "Not enough arguments for function.");
+
+        using func_type = ReturnType(*)(Args...);
+        func_type func = ptr_cast<func_type>(slot.func);
+#if defined(JSBIND_BINDING_STATS)
+        return timed_tuple_call<std::tuple<Args...>>(slot.stats_id, func, args, make_index_sequence<sizeof...(Args)>());
+#else
+        return tuple_call<std::tuple<Args...>>(func, args, make_index_sequence<sizeof...(Args)>());
+#endif
+    }
+
     inline JSValueRef call_from_jsc(
         JSContextRef ctx, JSObjectRef function, JSObjectRef thisObject,
         size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception)
     {
-        auto fdata = reinterpret_cast<function_private_data*>(JSObjectGetPrivate(function));
-        assert(fdata && "No private data for function");
-        return fdata->call(thisObject, argumentCount, arguments);
+        auto slot = reinterpret_cast<const static_function_slot*>(JSObjectGetPrivate(function));
+        assert(slot && "No private data for function");
+        return slot->invoke(*slot, argumentCount, arguments);
     }
 }
 }
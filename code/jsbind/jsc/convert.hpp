@@ -13,6 +13,7 @@
 #include "jsbind/common/wrapped_class.hpp"
 
 #include <string>
+#include <cstring>
 #include <type_traits>
 #include <climits>
 
@@ -26,6 +27,13 @@ namespace internal
     template <typename T, typename Enable = void> // enable used by enable_if specializations
     struct convert;
 
+    // creates a jsc string from utf-8 of a known length
+    // short strings, which are mostly property names, come from a cache
+    extern JSStringRef make_jsc_string(const char* str, size_t length);
+
+    // appends the utf-8 of a jsc string, read from its utf-16 characters
+    extern void append_utf8(std::string& out, JSStringRef str);
+
     template<>
     struct convert<const char*>
     {
@@ -37,7 +45,7 @@ namespace internal
 
         static JSValueRef to_jsc(const char* val)
         {
-            auto str = JSStringCreateWithUTF8CString(val);
+            auto str = to_jsc_string_copy(val);
             auto ret = JSValueMakeString(jsc_context, str);
 
             JSStringRelease(str);
@@ -47,7 +55,7 @@ namespace internal
 
         static JSStringRef to_jsc_string_copy(const char* val)
         {
-            return JSStringCreateWithUTF8CString(val);
+            return make_jsc_string(val, strlen(val));
         }
     };
 
@@ -59,14 +67,8 @@ namespace internal
 
         static type from_jsc_string(JSStringRef val)
         {
-            auto size = JSStringGetMaximumUTF8CStringSize(val);
-
             type ret;
-            ret.resize(size);
-
-            JSStringGetUTF8CString(val, &ret.front(), size);
-
-            ret.resize(strlen(ret.c_str()));
+            append_utf8(ret, val);
             return ret;
         }
 
@@ -82,12 +84,17 @@ namespace internal
 
         static JSValueRef to_jsc(const type& val)
         {
-            return convert<const char*>::to_jsc(val.c_str());
+            auto str = to_jsc_string_copy(val);
+            auto ret = JSValueMakeString(jsc_context, str);
+
+            JSStringRelease(str);
+
+            return ret;
         }
 
         static JSStringRef to_jsc_string_copy(const type& val)
         {
-            return convert<const char*>::to_jsc_string_copy(val.c_str());
+            return make_jsc_string(val.data(), val.size());
         }
     };
 
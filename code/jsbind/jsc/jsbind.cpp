@@ -7,15 +7,21 @@
 // http://opensource.org/licenses/MIT
 //
 #include "jsbind/funcs.hpp"
+#include "jsbind/context.hpp"
 #include "convert.hpp"
 #include "bind.hpp"
 #include "jsbind/console.hpp"
 #include "jsbind/exception.hpp"
+#include "jsbind/watchdog.hpp"
+#include "jsbind/post.hpp"
 #include "jsbind/common/deinitializers.hpp"
 
 #include <sstream>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
+#include <deque>
 
 using namespace jsbind::internal;
 
@@ -27,17 +33,24 @@ JSValueRef jsc_console_msg(jsbind::console::msg_type type, size_t num_args, cons
     auto undefined = JSValueMakeUndefined(jsbind::internal::jsc_context);
 
     auto con = jsbind::get_console();
-    if (!con) return undefined;
+    if (!con || !con->is_enabled(type)) return undefined;
+
+    // reused, so that formatting doesn't allocate once the buffer is big enough
+    static thread_local std::string buf;
+    buf.clear();
 
-    std::ostringstream sout;
     for (size_t i = 0; i < num_args; ++i)
     {
-        if (i) sout << ' ';
+        if (i) buf += ' ';
+
+        auto str = JSValueToStringCopy(jsbind::internal::jsc_context, args[i], nullptr);
+        if (!str) continue;
 
-        sout << from_jsc<std::string>(args[i]);
+        append_utf8(buf, str);
+        JSStringRelease(str);
     }
 
-    con->msg(type, sout.str().c_str());
+    con->msg(type, buf.c_str());
 
     return undefined;
 }
@@ -89,43 +102,490 @@ namespace internal
     JSGlobalContextRef jsc_context;
     extern void initialize_bindings();
 
-    JSObjectRef class_data::global = nullptr;
+    namespace
+    {
+    // direct mapped, so that a lookup is a hash and a compare
+    const size_t max_cached_string_length = 32;
+    const size_t string_cache_size = 512;
+
+    struct cached_string
+    {
+        char chars[max_cached_string_length];
+        size_t length;
+        JSStringRef str;
+    };
+
+    cached_string string_cache[string_cache_size];
+
+    void clear_string_cache()
+    {
+        for (auto& c : string_cache)
+        {
+            if (c.str) JSStringRelease(c.str);
+            c.str = nullptr;
+        }
+    }
+
+    size_t hash_chars(const char* str, size_t length)
+    {
+        // fnv-1a
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+        {
+            h = (h ^ uint8_t(str[i])) * 16777619u;
+        }
+        return h;
+    }
+
+    // strings up to this many bytes are converted in a buffer which is kept between calls
+    // longer ones (like whole scripts) get a buffer of their own, so it doesn't pin their size
+    const size_t max_reused_string_buffer = 64 * 1024;
+
+    // invalid utf-8 becomes U+FFFD, like in js
+    // buf must have room for `length` utf-16 units, as a string never has more than its utf-8 bytes
+    size_t utf8_to_utf16(const char* str, size_t length, JSChar* buf)
+    {
+        auto p = reinterpret_cast<const uint8_t*>(str);
+        auto end = p + length;
+        size_t n = 0;
+        while (p != end)
+        {
+            uint32_t c = *p++;
+            if (c < 0x80)
+            {
+                buf[n++] = JSChar(c);
+                continue;
+            }
+
+            // the number of continuation bytes
+            int extra = c < 0xc2 ? -1 : c < 0xe0 ? 1 : c < 0xf0 ? 2 : c < 0xf5 ? 3 : -1;
+            if (extra < 0 || end - p < extra)
+            {
+                buf[n++] = 0xfffd;
+                continue;
+            }
+
+            c &= 0x3f >> extra;
+            bool valid = true;
+            for (int i = 0; i < extra; ++i)
+            {
+                valid = valid && (p[i] & 0xc0) == 0x80;
+                c = (c << 6) | (p[i] & 0x3f);
+            }
+
+            // overlong encodings, surrogates and out of range code points
+            static const uint32_t min_code_point[] = { 0, 0x80, 0x800, 0x10000 };
+            if (!valid || c < min_code_point[extra] || (c >= 0xd800 && c < 0xe000) || c > 0x10ffff)
+            {
+                buf[n++] = 0xfffd;
+                continue;
+            }
+            p += extra;
+
+            if (c >= 0x10000)
+            {
+                c -= 0x10000;
+                buf[n++] = JSChar(0xd800 + (c >> 10));
+                buf[n++] = JSChar(0xdc00 + (c & 0x3ff));
+            }
+            else
+            {
+                buf[n++] = JSChar(c);
+            }
+        }
+
+        return n;
+    }
+
+    JSStringRef create_jsc_string(const char* str, size_t length)
+    {
+        if (length > max_reused_string_buffer)
+        {
+            std::vector<JSChar> buf(length);
+            return JSStringCreateWithCharacters(buf.data(), utf8_to_utf16(str, length, buf.data()));
+        }
+
+        // reused, so that converting doesn't allocate once the buffer is big enough
+        static thread_local std::vector<JSChar> buf;
+        if (buf.size() < length) buf.resize(length);
+        return JSStringCreateWithCharacters(buf.data(), utf8_to_utf16(str, length, buf.data()));
+    }
+    }
+
+    JSStringRef make_jsc_string(const char* str, size_t length)
+    {
+        if (length > max_cached_string_length)
+        {
+            return create_jsc_string(str, length);
+        }
+
+        auto& c = string_cache[hash_chars(str, length) & (string_cache_size - 1)];
+        if (c.str && c.length == length && memcmp(c.chars, str, length) == 0)
+        {
+            return JSStringRetain(c.str);
+        }
+
+        auto ret = create_jsc_string(str, length);
+        if (c.str) JSStringRelease(c.str);
+        memcpy(c.chars, str, length);
+        c.length = length;
+        c.str = JSStringRetain(ret);
+        return ret;
+    }
+
+    void append_utf8(std::string& out, JSStringRef str)
+    {
+        if (!str) return;
+
+        auto chars = JSStringGetCharactersPtr(str);
+        auto length = JSStringGetLength(str);
+
+        // the exact size first, so that the string is resized once
+        size_t size = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            auto c = chars[i];
+            if (c < 0x80) size += 1;
+            else if (c < 0x800) size += 2;
+            else if (c >= 0xd800 && c < 0xdc00 && i + 1 < length && chars[i + 1] >= 0xdc00 && chars[i + 1] < 0xe000)
+            {
+                size += 4;
+                ++i;
+            }
+            else size += 3; // including lone surrogates, which become U+FFFD
+        }
+
+        auto begin = out.size();
+        out.resize(begin + size);
+        auto p = &out[begin];
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            uint32_t c = chars[i];
+            if (c < 0x80)
+            {
+                *p++ = char(c);
+                continue;
+            }
+
+            if (c >= 0xd800 && c < 0xe000)
+            {
+                if (c < 0xdc00 && i + 1 < length && chars[i + 1] >= 0xdc00 && chars[i + 1] < 0xe000)
+                {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (chars[++i] - 0xdc00);
+                }
+                else
+                {
+                    c = 0xfffd;
+                }
+            }
+
+            if (c < 0x800)
+            {
+                *p++ = char(0xc0 | (c >> 6));
+            }
+            else if (c < 0x10000)
+            {
+                *p++ = char(0xe0 | (c >> 12));
+                *p++ = char(0x80 | ((c >> 6) & 0x3f));
+            }
+            else
+            {
+                *p++ = char(0xf0 | (c >> 18));
+                *p++ = char(0x80 | ((c >> 12) & 0x3f));
+                *p++ = char(0x80 | ((c >> 6) & 0x3f));
+            }
+            *p++ = char(0x80 | (c & 0x3f));
+        }
+    }
+
+    function_table class_data::global_functions;
+    std::vector<class_binding> class_data::classes;
     JSClassRef class_data::function_class = nullptr;
+    bool class_data::registering = false;
 
-    void report_exception(JSValueRef exception)
+    namespace
     {
-        auto eh = get_exception_handler();
-        if (!eh) return;
+    JSContextGroupRef context_group = nullptr;
+    JSGlobalContextRef main_context = nullptr;
+    JSClassRef console_class = nullptr;
+
+    // the number of functions which can be in static function tables
+    // functions registered after the trampolines run out are created as objects
+    const size_t num_static_function_slots = 1024;
+    const size_t static_function_block = 64;
+
+    static_function_slot static_function_slots[num_static_function_slots];
+    JSObjectCallAsFunctionCallback static_function_trampolines[num_static_function_slots];
+    size_t num_used_static_function_slots = 0;
+
+    // slots of the functions without a trampoline, stable as the function objects point to them
+    std::deque<static_function_slot> function_object_slots;
+
+    template <size_t I>
+    JSValueRef call_static_function(JSContextRef, JSObjectRef, JSObjectRef, size_t argumentCount, const JSValueRef arguments[], JSValueRef*)
+    {
+        auto& slot = static_function_slots[I];
+        return slot.invoke(slot, argumentCount, arguments);
+    }
+
+    template <size_t Base, size_t... I>
+    void fill_trampoline_block(index_sequence<I...>)
+    {
+        JSObjectCallAsFunctionCallback block[] = { call_static_function<Base + I>... };
+        for (size_t i = 0; i < sizeof...(I); ++i)
+        {
+            static_function_trampolines[Base + i] = block[i];
+        }
+    }
+
+    // in blocks, to keep the recursion of make_index_sequence shallow
+    template <size_t... B>
+    void fill_trampolines(index_sequence<B...>)
+    {
+        int expand[] = { (fill_trampoline_block<B * static_function_block>(make_index_sequence<static_function_block>()), 0)... };
+        (void)expand;
+    }
+
+    void set_property(JSContextRef ctx, JSObjectRef obj, const char* name, JSValueRef value)
+    {
+        auto str = to_jsc_string_copy(name);
+        JSObjectSetProperty(ctx, obj, str, value, kJSPropertyAttributeNone, nullptr);
+        JSStringRelease(str);
+    }
+
+    // adds console and Module to the global object of a new context
+    void install_globals(JSContextRef ctx)
+    {
+        auto global = JSContextGetGlobalObject(ctx);
+
+        set_property(ctx, global, "console", JSObjectMake(ctx, console_class, nullptr));
+
+        auto module = JSObjectMake(ctx, nullptr, nullptr);
+        set_property(ctx, global, "Module", module);
+
+        class_data::global_functions.install(ctx, module);
+        for (auto& c : class_data::classes)
+        {
+            auto obj = JSObjectMake(ctx, nullptr, nullptr);
+            c.functions.install(ctx, obj);
+            set_property(ctx, module, c.name, obj);
+        }
+    }
+
+    void clear_bindings()
+    {
+        class_data::global_functions.clear();
+        for (auto& c : class_data::classes)
+        {
+            c.functions.clear();
+        }
+        class_data::classes.clear();
+
+        num_used_static_function_slots = 0;
+        function_object_slots.clear();
+    }
+    }
+
+    registered_function register_function(const static_function_slot& slot)
+    {
+        registered_function ret = { nullptr, nullptr };
+
+        if (num_used_static_function_slots == num_static_function_slots)
+        {
+            function_object_slots.push_back(slot);
+            ret.slot = &function_object_slots.back();
+            return ret;
+        }
+
+        if (!static_function_trampolines[0])
+        {
+            fill_trampolines(make_index_sequence<num_static_function_slots / static_function_block>());
+        }
+
+        auto i = num_used_static_function_slots++;
+        static_function_slots[i] = slot;
+        ret.trampoline = static_function_trampolines[i];
+        ret.slot = &static_function_slots[i];
+        return ret;
+    }
+
+    void function_table::install(JSContextRef ctx, JSObjectRef obj)
+    {
+        if (!m_static_functions.empty())
+        {
+            if (!m_class)
+            {
+                // the class is shared by all contexts
+                m_static_functions.push_back(JSStaticFunction()); // null termination
+
+                JSClassDefinition def = kJSClassDefinitionEmpty;
+                def.attributes = kJSClassAttributeNoAutomaticPrototype;
+                def.staticFunctions = m_static_functions.data();
+                m_class = JSClassCreate(&def);
+
+                m_static_functions.pop_back();
+            }
+
+            // the object was created before its functions were known, so they're in its prototype
+            JSObjectSetPrototype(ctx, obj, JSObjectMake(ctx, m_class, nullptr));
+        }
+
+        for (auto& f : m_function_objects)
+        {
+            auto func = JSObjectMake(ctx, class_data::function_class, const_cast<static_function_slot*>(f.slot));
+            set_property(ctx, obj, f.name, func);
+        }
+    }
+
+    void function_table::clear()
+    {
+        if (m_class)
+        {
+            JSClassRelease(m_class);
+            m_class = nullptr;
+        }
+        m_static_functions.clear();
+        m_function_objects.clear();
+    }
+
+    namespace
+    {
+    // reads the parts of the exception from its properties when they're asked for
+    class jsc_exception_info : public exception_info
+    {
+    public:
+        explicit jsc_exception_info(JSValueRef exception)
+            : m_exception(exception)
+            , m_object(JSValueToObject(jsc_context, exception, nullptr))
+        {}
+
+        virtual std::string message() const override
+        {
+            return from_jsc<std::string>(m_exception);
+        }
+
+        virtual std::string resource() const override
+        {
+            return property_string("sourceURL");
+        }
+
+        virtual int line() const override
+        {
+            return property_int("line");
+        }
+
+        virtual int start_column() const override
+        {
+            int column = property_int("column");
+            return column ? column - 1 : 0;
+        }
+
+        virtual int end_column() const override
+        {
+            return start_column();
+        }
+
+        virtual std::string source_line() const override
+        {
+            // not available in jsc
+            return std::string();
+        }
+
+        // parsed from the stack property, whose lines are `function@url:line:column`
+        virtual std::vector<stack_frame> frames() const override
+        {
+            std::vector<stack_frame> ret;
+            auto stack = property_string("stack");
+            auto depth = size_t(get_exception_stack_depth());
+
+            size_t begin = 0;
+            while (begin < stack.length() && ret.size() < depth)
+            {
+                auto end = stack.find('\n', begin);
+                if (end == std::string::npos) end = stack.length();
+
+                stack_frame frame = { std::string(), std::string(), 0, 0 };
+                auto line = stack.substr(begin, end - begin);
+                auto at = line.find('@');
+                if (at != std::string::npos)
+                {
+                    frame.function = line.substr(0, at);
+                    line = line.substr(at + 1);
+                }
+
+                // the url can contain colons too, so the numbers are taken from the end
+                auto col_sep = line.rfind(':');
+                auto line_sep = col_sep == std::string::npos || col_sep == 0 ? std::string::npos : line.rfind(':', col_sep - 1);
+                if (line_sep != std::string::npos)
+                {
+                    frame.line = atoi(line.c_str() + line_sep + 1);
+                    frame.column = atoi(line.c_str() + col_sep + 1);
+                    line = line.substr(0, line_sep);
+                }
+                frame.resource = line;
+
+                ret.push_back(frame);
+                begin = end + 1;
+            }
+
+            return ret;
+        }
 
-        std::stringstream sout;
+        virtual std::string text() const override
+        {
+            std::stringstream sout;
+
+            auto ex = message();
+            sout << ex << " at " << property_string("line") << " in " << resource() << std::endl;
+            sout << "Stack trace:" << std::endl;
+            sout << ex << std::endl;
+            sout << property_string("stack") << std::endl;
+
+            return sout.str();
+        }
+
+    private:
+        JSValueRef property(const char* name) const
+        {
+            if (!m_object) return JSValueMakeUndefined(jsc_context);
 
-        JSStringRef jsLinePropertyName = JSStringCreateWithUTF8CString("line");
-        JSStringRef jsFilePropertyName = JSStringCreateWithUTF8CString("sourceURL");
-        JSStringRef jsStackTraceName = JSStringCreateWithUTF8CString("stack");
+            JSStringRef str = to_jsc_string_copy(name);
+            JSValueRef ret = JSObjectGetProperty(jsc_context, m_object, str, nullptr);
+            JSStringRelease(str);
+            return ret;
+        }
 
-        JSObjectRef exObject = JSValueToObject(jsc_context, exception, NULL);
-        JSValueRef line = JSObjectGetProperty(jsc_context, exObject, jsLinePropertyName, NULL);
-        JSValueRef file = JSObjectGetProperty(jsc_context, exObject, jsFilePropertyName, NULL);
+        std::string property_string(const char* name) const
+        {
+            return from_jsc<std::string>(property(name));
+        }
 
-        auto ex = from_jsc<std::string>(exception);
-        sout << ex << " at " << from_jsc<std::string>(line) << " in " << from_jsc<std::string>(file) << std::endl;
-        sout << "Stack trace:" << std::endl;
+        int property_int(const char* name) const
+        {
+            auto val = property(name);
+            return JSValueIsNumber(jsc_context, val) ? int(JSValueToNumber(jsc_context, val, nullptr)) : 0;
+        }
 
-        JSValueRef stackTrace = JSObjectGetProperty(jsc_context, exObject, jsStackTraceName, NULL);
-        sout << ex << std::endl;
-        sout << from_jsc<std::string>(stackTrace) << std::endl;
+        JSValueRef m_exception;
+        JSObjectRef m_object;
+    };
+    }
 
-        JSStringRelease(jsLinePropertyName);
-        JSStringRelease(jsFilePropertyName);
-        JSStringRelease(jsStackTraceName);
+    void report_exception(JSValueRef exception)
+    {
+        auto eh = get_exception_handler();
+        if (!eh) return;
 
-        eh->on_exception(sout.str().c_str());
+        jsc_exception_info info(exception);
+        eh->on_exception_info(info);
     }
 }
 
 void initialize()
 {
-    jsc_context = JSGlobalContextCreate(nullptr);
+    context_group = JSContextGroupCreate();
+    main_context = jsc_context = JSGlobalContextCreateInGroup(context_group, nullptr);
 
     set_default_exception_handler();
 
@@ -134,11 +594,7 @@ void initialize()
         JSClassDefinition js_def = kJSClassDefinitionEmpty;
         js_def.attributes = kJSClassAttributeNoAutomaticPrototype;
         js_def.className = "JSBindFunction";
-        js_def.callAsFunction = call_from_jsc;
-        js_def.finalize = [](JSObjectRef f)
-        {
-            delete reinterpret_cast<function_private_data*>(JSObjectGetPrivate(f));
-        };
+        js_def.callAsFunction = call_from_jsc; // the private data is a slot, owned by the bindings
         class_data::function_class = JSClassCreate(&js_def);
     }
 
@@ -156,35 +612,37 @@ void initialize()
     };
 
     console_def.staticFunctions = console_funcs;
-    auto console_class = JSClassCreate(&console_def);
-
-    // init bindings
-    class_data::global = JSObjectMake(internal::jsc_context, nullptr, nullptr);
-    JSValueProtect(internal::jsc_context, class_data::global);
+    console_class = JSClassCreate(&console_def);
 
+    // the bindings are registered once and installed into every context
+    class_data::registering = true;
     initialize_bindings();
+    class_data::registering = false;
+    install_globals(jsc_context);
 
-    auto global = JSContextGetGlobalObject(jsc_context);
-
-    auto str_console = to_jsc_string_copy("console");
-    JSObjectRef console_obj = JSObjectMake(internal::jsc_context, console_class, nullptr);
-    JSObjectSetProperty(internal::jsc_context, global, str_console, console_obj, kJSPropertyAttributeNone, nullptr);
-    JSStringRelease(str_console);
-
-    auto str_module = to_jsc_string_copy("Module");
-    JSObjectSetProperty(internal::jsc_context, global, str_module, class_data::global, kJSPropertyAttributeNone, nullptr);
-    JSStringRelease(str_module);
-
-    JSValueUnprotect(internal::jsc_context, class_data::global);
-    class_data::global = nullptr;
+    initialize_posted_tasks();
 }
 
 void deinitialize()
 {
     internal::run_deinitializers();
 
-    JSGlobalContextRelease(jsc_context);
-    jsc_context = nullptr;
+    assert(jsc_context == main_context && "deinitializing with a context entered");
+
+    JSGlobalContextRelease(main_context);
+    main_context = jsc_context = nullptr;
+
+    JSContextGroupRelease(context_group);
+    context_group = nullptr;
+
+    clear_bindings();
+
+    clear_string_cache();
+
+    JSClassRelease(console_class);
+    console_class = nullptr;
+    JSClassRelease(class_data::function_class);
+    class_data::function_class = nullptr;
 }
 
 void enter_context()
@@ -195,15 +653,45 @@ void exit_context()
 {
 }
 
+context::context()
+    : m_context(nullptr)
+    , m_previous(nullptr)
+{
+    assert(context_group && "creating a context before jsbind::initialize");
+    m_context = JSGlobalContextCreateInGroup(context_group, nullptr);
+    install_globals(m_context);
+}
+
+context::~context()
+{
+    assert(!m_previous && "destroying an entered context");
+    JSGlobalContextRelease(m_context);
+}
+
+void context::enter()
+{
+    assert(!m_previous && "the context is already entered");
+    m_previous = jsc_context;
+    jsc_context = m_context;
+}
+
+void context::exit()
+{
+    assert(jsc_context == m_context && "exiting a context which isn't the current one");
+    jsc_context = m_previous;
+    m_previous = nullptr;
+}
+
 extern "C" JS_EXPORT void JSGarbageCollect(JSContextRef);
 
 void run_script(const char* src, const char* fname)
 {
-    auto source = JSStringCreateWithUTF8CString(src);
-    auto filename = fname ? JSStringCreateWithUTF8CString(fname) : nullptr;
+    auto source = make_jsc_string(src, strlen(src));
+    auto filename = fname ? to_jsc_string_copy(fname) : nullptr;
 
     if (source)
     {
+        watchdog_scope watch(true);
         JSValueRef exception = nullptr;
         JSEvaluateScript(jsc_context, source, nullptr, filename, 0, &exception);
 
@@ -12,6 +12,11 @@
 #include "call.hpp"
 #include <vector>
 #include <functional>
+#include <cstdint>
+
+#if defined(_JSC_TYPED_ARRAYS)
+#   include <JavaScriptCore/JSTypedArray.h>
+#endif
 
 #if defined(JSBIND_DEBUGGING)
 extern "C" JS_EXPORT void JSGarbageCollect(JSContextRef);
@@ -232,11 +237,76 @@ private:
     friend class persistent;
 };
 
+namespace internal
+{
+#if defined(_JSC_TYPED_ARRAYS)
+    // the elements of a typed array, or nullptr if the value isn't one
+    inline void* jsc_typed_array_elements(JSValueRef value, JSTypedArrayType& type, size_t& length)
+    {
+        type = JSValueGetTypedArrayType(jsc_context, value, nullptr);
+        if (type == kJSTypedArrayTypeNone || type == kJSTypedArrayTypeArrayBuffer) return nullptr;
+
+        auto obj = JSValueToObject(jsc_context, value, nullptr);
+        auto bytes = reinterpret_cast<uint8_t*>(JSObjectGetTypedArrayBytesPtr(jsc_context, obj, nullptr));
+        if (!bytes) return nullptr;
+
+        length = JSObjectGetTypedArrayLength(jsc_context, obj, nullptr);
+        // the pointer is to the start of the buffer and not of the view
+        return bytes + JSObjectGetTypedArrayByteOffset(jsc_context, obj, nullptr);
+    }
+
+    template <typename T, typename E>
+    void assign_elements(std::vector<T>& vec, const void* data, size_t length)
+    {
+        auto elements = reinterpret_cast<const E*>(data);
+        vec.assign(elements, elements + length);
+    }
+
+    // reads a typed array in bulk instead of an element at a time
+    template <typename T>
+    bool typed_array_to_vector(JSValueRef value, std::vector<T>& vec, std::true_type /*is_arithmetic*/)
+    {
+        JSTypedArrayType type;
+        size_t length = 0;
+        auto data = jsc_typed_array_elements(value, type, length);
+        if (!data) return false;
+
+        switch (type)
+        {
+        case kJSTypedArrayTypeInt8Array: assign_elements<T, int8_t>(vec, data, length); break;
+        case kJSTypedArrayTypeUint8Array:
+        case kJSTypedArrayTypeUint8ClampedArray: assign_elements<T, uint8_t>(vec, data, length); break;
+        case kJSTypedArrayTypeInt16Array: assign_elements<T, int16_t>(vec, data, length); break;
+        case kJSTypedArrayTypeUint16Array: assign_elements<T, uint16_t>(vec, data, length); break;
+        case kJSTypedArrayTypeInt32Array: assign_elements<T, int32_t>(vec, data, length); break;
+        case kJSTypedArrayTypeUint32Array: assign_elements<T, uint32_t>(vec, data, length); break;
+        case kJSTypedArrayTypeFloat32Array: assign_elements<T, float>(vec, data, length); break;
+        case kJSTypedArrayTypeFloat64Array: assign_elements<T, double>(vec, data, length); break;
+        default: return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool typed_array_to_vector(JSValueRef, std::vector<T>&, std::false_type)
+    {
+        return false;
+    }
+#endif
+}
+
 template<typename T>
 std::vector<T> vecFromJSArray(local v) {
+    std::vector<T> ret;
+#if defined(_JSC_TYPED_ARRAYS)
+    if (internal::typed_array_to_vector(v.m_handle, ret, std::is_arithmetic<T>()))
+    {
+        return ret;
+    }
+#endif
+
     auto l = v["length"].as<unsigned>();
 
-    std::vector<T> ret;
     ret.reserve(l);
     for (unsigned i = 0; i < l; ++i) {
         ret.emplace_back(v[i].as<T>());
@@ -280,71 +350,112 @@ namespace internal
     }
 }
 
+namespace internal
+{
+    // a protected value shared by the persistents which are copies of each other
+    // so that copying a persistent is an increment instead of a lookup in jsc's set of protected values
+    // the refcount is not atomic, as persistents (like all handles) are used by the js thread only
+    struct persistent_cell
+    {
+        explicit persistent_cell(JSValueRef v)
+            : value(v)
+            , refs(1)
+        {
+            JSValueProtect(jsc_context, value);
+        }
+
+        ~persistent_cell()
+        {
+            JSValueUnprotect(jsc_context, value);
+        }
+
+        JSValueRef value;
+        size_t refs;
+    };
+}
+
 class persistent
 {
 public:
     persistent()
-        : m_handle(nullptr)
+        : m_cell(nullptr)
     {}
 
     persistent(const persistent& other)
-        : persistent(other.m_handle)
-    {}
+        : m_cell(other.m_cell)
+    {
+        if (m_cell) ++m_cell->refs;
+    }
 
     persistent(persistent&& other)
-        : m_handle(other.m_handle)
+        : m_cell(other.m_cell)
     {
-        other.m_handle = nullptr;
+        other.m_cell = nullptr;
     }
 
+    // an empty local makes an empty persistent
     explicit persistent(const local& local)
-        : persistent(local.m_handle)
+        : m_cell(local.m_handle ? new internal::persistent_cell(local.m_handle) : nullptr)
     {}
 
     ~persistent()
     {
-        if (m_handle) JSValueUnprotect(internal::jsc_context, m_handle);
+        release();
     }
 
     void reset()
     {
-        if (m_handle) JSValueUnprotect(internal::jsc_context, m_handle);
-        m_handle = nullptr;
+        release();
+        m_cell = nullptr;
     }
 
     void reset(const local& l)
     {
-        reset();
-        m_handle = l.m_handle;
-        JSValueProtect(internal::jsc_context, m_handle);
+        // protected before the old value is released, in case it's the same
+        auto cell = l.m_handle ? new internal::persistent_cell(l.m_handle) : nullptr;
+        release();
+        m_cell = cell;
     }
 
     local to_local() const
     {
-        return local(m_handle);
+        return local(m_cell ? m_cell->value : nullptr);
     }
 
     bool is_empty() const
     {
-        return m_handle == nullptr;
+        return m_cell == nullptr;
     }
 
     persistent& operator=(const persistent& other)
     {
-        if (m_handle) JSValueUnprotect(internal::jsc_context, m_handle);
-        m_handle = other.m_handle;
-        JSValueProtect(internal::jsc_context, m_handle);
+        if (other.m_cell) ++other.m_cell->refs;
+        release();
+        m_cell = other.m_cell;
+        return *this;
+    }
+
+    persistent& operator=(persistent&& other)
+    {
+        if (this != &other)
+        {
+            release();
+            m_cell = other.m_cell;
+            other.m_cell = nullptr;
+        }
         return *this;
     }
 
 private:
-    explicit persistent(JSValueRef val)
-        : m_handle(val)
+    void release()
     {
-        JSValueProtect(internal::jsc_context, m_handle);
+        if (m_cell && --m_cell->refs == 0)
+        {
+            delete m_cell;
+        }
     }
 
-    JSValueRef m_handle;
+    internal::persistent_cell* m_cell;
 };
 
 }
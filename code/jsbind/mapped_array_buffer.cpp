@@ -0,0 +1,185 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "mapped_array_buffer.hpp"
+
+#if defined(_WIN32)
+#   if !defined(NOMINMAX)
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#include <map>
+#include <string>
+#include <mutex>
+
+using namespace jsbind::internal;
+
+namespace
+{
+
+// the stores in the map are not referenced by it
+// a store removes itself from the map when it's destroyed
+std::mutex mappings_mutex;
+std::map<std::string, backing_store*> mappings;
+
+struct mapping
+{
+    std::string path; // empty for private mappings
+    backing_store* store;
+};
+
+void advise(uint8_t* data, size_t size, jsbind::mapped_array_buffer::access_hint hint)
+{
+#if defined(_WIN32)
+    // no madvise equivalent worth the trouble
+    (void)data; (void)size; (void)hint;
+#else
+    int advice = MADV_NORMAL;
+    switch (hint)
+    {
+    case jsbind::mapped_array_buffer::access_sequential: advice = MADV_SEQUENTIAL; break;
+    case jsbind::mapped_array_buffer::access_random: advice = MADV_RANDOM; break;
+    case jsbind::mapped_array_buffer::access_will_need: advice = MADV_WILLNEED; break;
+    default: break;
+    }
+    madvise(data, size, advice);
+#endif
+}
+
+void unmap(uint8_t* data, size_t size, void* user_data)
+{
+    auto m = reinterpret_cast<mapping*>(user_data);
+
+    if (!m->path.empty())
+    {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        auto f = mappings.find(m->path);
+        // the path may have been mapped anew while this store was dying
+        if (f != mappings.end() && f->second == m->store)
+        {
+            mappings.erase(f);
+        }
+    }
+
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+
+    delete m;
+}
+
+backing_store* map_file(const char* path, bool shared)
+{
+    size_t size = 0;
+    void* data = nullptr;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    size = size_t(file_size.QuadPart);
+
+    HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!file_mapping) return nullptr;
+
+    // the view keeps the file mapping alive
+    data = MapViewOfFile(file_mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(file_mapping);
+    if (!data) return nullptr;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    size = size_t(st.st_size);
+
+    // the mapping keeps the file open
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+#endif
+
+    auto m = new mapping;
+    if (shared) m->path = path;
+    m->store = backing_store::wrap(reinterpret_cast<uint8_t*>(data), size, unmap, m);
+    return m->store;
+}
+
+jsbind::mapped_array_buffer adopt_mapping(backing_store* store, jsbind::mapped_array_buffer::access_hint hint)
+{
+    if (store)
+    {
+        advise(store->data(), store->size(), hint);
+    }
+    else
+    {
+        store = backing_store::wrap(nullptr, 0);
+    }
+
+    jsbind::mapped_array_buffer ret(store);
+    store->release(); // the buffer holds its own reference
+    return ret;
+}
+
+}
+
+namespace jsbind
+{
+
+mapped_array_buffer mapped_array_buffer::open(const char* path, access_hint hint)
+{
+    backing_store* store = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mappings_mutex);
+        auto f = mappings.find(path);
+        if (f != mappings.end() && f->second->try_add_ref())
+        {
+            store = f->second;
+        }
+        else
+        {
+            store = map_file(path, true);
+            if (store)
+            {
+                mappings[path] = store;
+            }
+        }
+    }
+
+    return adopt_mapping(store, hint);
+}
+
+mapped_array_buffer mapped_array_buffer::open_private(const char* path, access_hint hint)
+{
+    return adopt_mapping(map_file(path, false), hint);
+}
+
+}
@@ -0,0 +1,63 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "shared_memory_extension.hpp"
+
+namespace jsbind
+{
+
+/// The contents of a file exposed to js as an ArrayBuffer without copying.
+///
+/// The file is memory mapped once per process. Opening the same path again
+/// (from any isolate or thread) shares the mapping and with it the physical
+/// pages. The mapping is released when the last c++ buffer and js object which
+/// use it are gone.
+///
+/// The mapping is copy-on-write, so writes from js can't crash the process or
+/// alter the file. BUT THEY ARE VISIBLE TO ALL OTHER OPENERS OF THE PATH, as they
+/// share the pages. Treat buffers from `open` as read-only and use `open_private`
+/// for contents which are going to be modified.
+class mapped_array_buffer : public internal::buffer<mapped_array_buffer>
+{
+public:
+    enum access_hint
+    {
+        access_normal,
+        access_sequential,
+        access_random,
+        access_will_need, // prefetch the whole file
+    };
+
+    /// Maps the file at `path`.
+    /// On failure (or for an empty file) the result is an empty buffer.
+    static mapped_array_buffer open(const char* path, access_hint hint = access_normal);
+
+    /// Maps the file at `path` with a mapping of its own, which isn't shared with
+    /// any other opener. Writes to it are seen only through this buffer.
+    static mapped_array_buffer open_private(const char* path, access_hint hint = access_normal);
+
+    explicit mapped_array_buffer(internal::backing_store* store) : buffer(store) {}
+    explicit mapped_array_buffer(const internal::backing_store_ptr& store) : buffer(store.get()) {}
+
+    bool is_mapped() const { return m_buffer != nullptr; }
+
+    void init()
+    {
+#if defined(JSBIND_EMSCRIPTEN)
+        auto u8a = local(emscripten::typed_memory_view(m_size, m_buffer));
+        auto obj = u8a["buffer"];
+#else
+        auto obj = internal::make_external_array_buffer(m_buffer, m_size, new_js_ref());
+#endif
+        m_persistent.reset(obj);
+    }
+};
+
+}
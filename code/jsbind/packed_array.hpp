@@ -0,0 +1,307 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "bind.hpp"
+#include "shared_memory_extension.hpp"
+#include "jsbind/common/deinitializers.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+namespace jsbind
+{
+namespace internal
+{
+    // creates a js class with accessors for a packed struct
+    // the struct is read through a DataView in little endian, which is what all supported platforms use
+    // fields is an array of [name, offset, DataView type]
+    static const char* const packed_class_factory_src = R"js(
+(function (fields, stride) {
+    function Item(view, offset) {
+        this.view = view;
+        this.offset = offset;
+    }
+    fields.forEach(function (f) {
+        var get = DataView.prototype['get' + f[2]], set = DataView.prototype['set' + f[2]], off = f[1];
+        Object.defineProperty(Item.prototype, f[0], {
+            get: function () { return get.call(this.view, this.offset + off, true); },
+            set: function (v) { set.call(this.view, this.offset + off, v, true); },
+            enumerable: true
+        });
+    });
+    function Packed(buffer, length) {
+        this.buffer = buffer;
+        this.length = length === undefined ? Math.floor(buffer.byteLength / stride) : length;
+        this.view = new DataView(buffer);
+    }
+    function isBuffer(v) { return Object.prototype.toString.call(v) === '[object ArrayBuffer]'; }
+    Packed.stride = stride;
+    Packed.wrap = function (buffer, length) { return new Packed(buffer, length); };
+    Packed.encode = function (objs) {
+        var p = new Packed(new ArrayBuffer(objs.length * stride), objs.length);
+        for (var i = 0; i < objs.length; ++i) {
+            var it = p.get(i), o = objs[i];
+            fields.forEach(function (f) { it[f[0]] = o[f[0]]; });
+        }
+        return p;
+    };
+    // the bytes of a packed array, an array buffer or a view: [buffer, byte offset, byte length]
+    Packed.span = function (v) {
+        if (ArrayBuffer.isView(v)) return [v.buffer, v.byteOffset, v.byteLength];
+        if (isBuffer(v)) return [v, 0, v.byteLength];
+        if (v && isBuffer(v.buffer) && typeof v.length === 'number') {
+            return [v.buffer, 0, Math.min(v.buffer.byteLength, v.length * stride)];
+        }
+        throw new TypeError('packed_array: expected a packed array, an ArrayBuffer or a view of one');
+    };
+    Packed.prototype.get = function (i) { return new Item(this.view, i * stride); };
+    Packed.prototype.toArray = function () {
+        var ret = [];
+        for (var i = 0; i < this.length; ++i) {
+            var it = this.get(i), o = {};
+            fields.forEach(function (f) { o[f[0]] = it[f[0]]; });
+            ret.push(o);
+        }
+        return ret;
+    };
+    return Packed;
+})
+)js";
+
+    inline const char* data_view_type_name(typed_array_type type)
+    {
+        switch (type)
+        {
+        case typed_array_type::int8: return "Int8";
+        case typed_array_type::uint8: return "Uint8";
+        case typed_array_type::int16: return "Int16";
+        case typed_array_type::uint16: return "Uint16";
+        case typed_array_type::int32: return "Int32";
+        case typed_array_type::uint32: return "Uint32";
+        case typed_array_type::float32: return "Float32";
+        case typed_array_type::float64: return "Float64";
+        default: return nullptr;
+        }
+    }
+}
+
+/// Arrays of value_object structs in a single array buffer.
+///
+/// The struct must be trivially copyable and marked as a `packed_struct`, so that all
+/// of its registered fields are numbers. The bytes of the structs are shared with js as they are, so sending
+/// an array is one memcpy instead of an object per element. In js the array is an
+/// instance of a class generated from the value_object fields:
+///
+///     var p = module.getSnapshot();
+///     p.length;           // number of structs
+///     p.get(i).x;         // reads the field x of the i-th struct from the buffer
+///     p.get(i).x = 5;     // writes it
+///     p.toArray();        // plain objects, as value_object would convert them
+///
+/// The class is also available as `packed_array<T>::js_class()` and has a static
+/// `encode(objects)` which packs plain objects for sending packed arrays back to C++.
+/// Converting from js copies the bytes of the array once.
+template <typename T>
+class packed_array
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "packed_array: the struct must be trivially copyable");
+    static_assert(packed_struct<T>::value, "packed_array: the struct must be marked as a packed_struct");
+
+    packed_array(const T* data, size_t size)
+        : m_size(size)
+        , m_store(internal::backing_store::allocate(size * sizeof(T)))
+    {
+        if (size)
+        {
+            memcpy(m_store->data(), data, size * sizeof(T));
+        }
+    }
+
+    explicit packed_array(const std::vector<T>& vec)
+        : packed_array(vec.data(), vec.size())
+    {}
+
+    // uninitialized structs
+    explicit packed_array(size_t size)
+        : m_size(size)
+        , m_store(internal::backing_store::allocate(size * sizeof(T)))
+    {}
+
+    packed_array(packed_array&& other)
+        : m_size(other.m_size)
+        , m_store(other.m_store)
+    {
+        other.m_size = 0;
+        other.m_store = nullptr;
+    }
+
+    packed_array(const packed_array&) = delete;
+    packed_array& operator=(const packed_array&) = delete;
+
+    ~packed_array()
+    {
+        if (m_store)
+        {
+            m_store->release();
+        }
+    }
+
+    size_t size() const { return m_size; }
+
+    const T* data() const { return m_store ? reinterpret_cast<const T*>(m_store->data()) : nullptr; }
+    T* data() { return m_store ? reinterpret_cast<T*>(m_store->data()) : nullptr; }
+
+    std::vector<T> to_vector() const
+    {
+        return std::vector<T>(data(), data() + m_size);
+    }
+
+    // the js object shares the memory of the array
+    local to_local() const
+    {
+        array_buffer buf(m_store);
+        return js_class().template call<local>("wrap", buf.get_persistent().to_local(), uint32_t(m_size));
+    }
+
+    // accepts a packed js object, an array buffer or a view of one
+    // anything else is reported as a js error and gives an empty array
+    static packed_array from_local(const local& val)
+    {
+        auto span = js_class().template call<local>("span", val);
+        if (span.isUndefined())
+        {
+            // the exception is already reported
+            return packed_array(nullptr, 0);
+        }
+
+        auto offset = span[1].as<uint32_t>();
+        auto length = span[2].as<uint32_t>();
+
+        // one copy, from the js buffer straight into the new store
+        packed_array ret(length / sizeof(T));
+        if (ret.m_size)
+        {
+            internal::copy_array_buffer(span[0], offset, ret.m_size * sizeof(T), ret.m_store->data());
+        }
+        return ret;
+    }
+
+    static local js_class()
+    {
+        if (m_js_class.is_empty())
+        {
+            create_js_class();
+        }
+
+        return m_js_class.to_local();
+    }
+
+private:
+    static void create_js_class()
+    {
+        assert(value_object<T>::is_bound && "packed_array of an unbound value_object");
+
+        auto fields = local::array();
+        uint32_t i = 0;
+        for (auto& field : value_object<T>::fields)
+        {
+            auto& layout = field.layout;
+
+            auto desc = local::array();
+            desc.set(0, layout.name);
+            desc.set(1, uint32_t(layout.offset));
+            desc.set(2, internal::data_view_type_name(layout.type));
+            fields.set(i++, desc);
+        }
+
+        auto factory = local::global("eval")(internal::packed_class_factory_src);
+        m_js_class.reset(factory(fields, uint32_t(sizeof(T))));
+
+        internal::add_deinitializer(packed_array::clear_js_class);
+    }
+
+    static void clear_js_class()
+    {
+        m_js_class.reset();
+    }
+
+    size_t m_size;
+    internal::backing_store* m_store;
+
+    static persistent m_js_class;
+};
+
+template <typename T>
+persistent packed_array<T>::m_js_class;
+
+namespace internal
+{
+    template <typename T>
+    struct is_wrapped_class<packed_array<T>> : std::false_type {};
+
+#if defined(JSBIND_V8)
+    template <typename T>
+    struct convert<packed_array<T>>
+    {
+        using from_type = packed_array<T>;
+        using to_type = v8::Local<v8::Value>;
+
+        static from_type from_v8(v8::Local<v8::Value> val)
+        {
+            return from_type::from_local(local(val));
+        }
+
+        static to_type to_v8(const from_type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+#elif defined(JSBIND_JSC)
+    template <typename T>
+    struct convert<packed_array<T>>
+    {
+        using type = packed_array<T>;
+
+        static type from_jsc(JSValueRef val)
+        {
+            return type::from_local(local(val));
+        }
+
+        static JSValueRef to_jsc(const type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+#elif defined(JSBIND_CEF)
+    template <typename T>
+    struct convert<packed_array<T>>
+    {
+        using type = packed_array<T>;
+
+        static type from_cef(CefRefPtr<CefV8Value> val)
+        {
+            return type::from_local(local(val));
+        }
+
+        static CefRefPtr<CefV8Value> to_cef(const type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+#endif
+}
+
+}
+
+#endif
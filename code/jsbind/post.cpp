@@ -0,0 +1,181 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "post.hpp"
+
+#include "jsbind/value.hpp"
+#include "jsbind/exception.hpp"
+#include "jsbind/common/mpsc_queue.hpp"
+#include "jsbind/common/deinitializers.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <exception>
+#include <string>
+
+#if defined(JSBIND_NODE)
+#   include <uv.h>
+#endif
+
+namespace jsbind
+{
+
+namespace
+{
+using clock = std::chrono::steady_clock;
+
+struct posted_task
+{
+    std::function<void()> func;
+    clock::time_point posted;
+};
+
+internal::mpsc_list<posted_task> g_tasks;
+std::atomic<uint64_t> g_posted(0);
+std::atomic<uint64_t> g_run(0);
+histogram g_wait_us;
+bool g_initialized = false;
+
+// the tasks which didn't run are dropped, which breaks the promises of post_with_result
+void clear_posted_tasks()
+{
+    posted_task task;
+    while (g_tasks.try_pop(task))
+    {
+        g_run.fetch_add(1, std::memory_order_release);
+    }
+    g_initialized = false;
+}
+
+void report_task_exception(const char* what)
+{
+    if (auto eh = jsbind::get_exception_handler())
+    {
+        eh->on_exception((std::string("jsbind: posted task threw: ") + what).c_str());
+    }
+}
+
+#if defined(JSBIND_NODE)
+// the posting threads send to the handle under the lock, so it can't be closed in the middle of a send
+std::mutex g_async_mutex;
+uv_async_t* g_async = nullptr;
+
+void on_async(uv_async_t*)
+{
+    using namespace internal;
+
+    // the event loop calls us outside of any scope
+    v8::HandleScope scope(isolate);
+    v8::Context::Scope context_scope(ctx.to_local());
+    run_posted_tasks();
+}
+
+void close_async()
+{
+    uv_async_t* async;
+    {
+        std::lock_guard<std::mutex> lock(g_async_mutex);
+        async = g_async;
+        g_async = nullptr;
+    }
+
+    uv_close(reinterpret_cast<uv_handle_t*>(async), [](uv_handle_t* handle) {
+        delete reinterpret_cast<uv_async_t*>(handle);
+    });
+}
+#endif
+}
+
+void post(std::function<void()> task)
+{
+    g_tasks.push({ std::move(task), clock::now() });
+    g_posted.fetch_add(1, std::memory_order_release);
+
+#if defined(JSBIND_NODE)
+    std::lock_guard<std::mutex> lock(g_async_mutex);
+    if (g_async)
+    {
+        // coalesced by libuv, so there's at most one wake up per loop iteration
+        uv_async_send(g_async);
+    }
+#endif
+}
+
+size_t run_posted_tasks(size_t max_tasks)
+{
+    scope s;
+
+    size_t count = 0;
+    posted_task task;
+    while (count < max_tasks && g_tasks.try_pop(task))
+    {
+        auto wait = clock::now() - task.posted;
+        g_wait_us.record(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(wait).count()));
+
+        // a throwing task doesn't stop the ones after it
+        try
+        {
+            task.func();
+        }
+        catch (const std::exception& e)
+        {
+            report_task_exception(e.what());
+        }
+        catch (...)
+        {
+            report_task_exception("unknown exception");
+        }
+        task.func = nullptr;
+
+        g_run.fetch_add(1, std::memory_order_release);
+        ++count;
+    }
+
+    return count;
+}
+
+post_queue_stats get_post_queue_stats(bool roll)
+{
+    post_queue_stats ret;
+    auto run = g_run.load(std::memory_order_acquire);
+    ret.posted = g_posted.load(std::memory_order_acquire);
+    ret.depth = ret.posted > run ? ret.posted - run : 0;
+    ret.wait_us = roll ? g_wait_us.roll() : g_wait_us.get();
+    return ret;
+}
+
+namespace internal
+{
+
+void initialize_posted_tasks()
+{
+    if (g_initialized) return;
+    g_initialized = true;
+
+    add_deinitializer(clear_posted_tasks);
+
+#if defined(JSBIND_NODE)
+    auto async = new uv_async_t;
+    uv_async_init(uv_default_loop(), async, on_async);
+
+    // waiting for posted tasks doesn't keep node running
+    uv_unref(reinterpret_cast<uv_handle_t*>(async));
+
+    {
+        std::lock_guard<std::mutex> lock(g_async_mutex);
+        g_async = async;
+    }
+
+    add_deinitializer(close_async);
+#endif
+}
+
+}
+
+}
@@ -0,0 +1,96 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "jsbind/common/histogram.hpp"
+
+#include <functional>
+#include <future>
+#include <exception>
+#include <memory>
+#include <cstdint>
+
+namespace jsbind
+{
+
+/// Queues a function to be called on the js thread.
+/// Can be called from any thread. The tasks run in the order they were posted
+/// (per posting thread) when the js thread calls `run_posted_tasks`.
+/// On node they're also run by the event loop, without a call to `run_posted_tasks`.
+extern void post(std::function<void()> task);
+
+namespace internal
+{
+    template <typename T, typename F>
+    void fulfill(std::promise<T>& p, F& f)
+    {
+        try
+        {
+            p.set_value(f());
+        }
+        catch (...)
+        {
+            p.set_exception(std::current_exception());
+        }
+    }
+
+    template <typename F>
+    void fulfill(std::promise<void>& p, F& f)
+    {
+        try
+        {
+            f();
+            p.set_value();
+        }
+        catch (...)
+        {
+            p.set_exception(std::current_exception());
+        }
+    }
+}
+
+/// Queues a function to be called on the js thread and returns a future of its result.
+/// Don't wait for the future on the js thread, before the task has run.
+/// An exception thrown by the task is stored in the future. If jsbind is deinitialized
+/// before the task runs, the future has a broken_promise error.
+template <typename T, typename F>
+std::future<T> post_with_result(F task)
+{
+    auto p = std::make_shared<std::promise<T>>();
+    auto ret = p->get_future();
+    post([p, task]() mutable {
+        internal::fulfill(*p, task);
+    });
+    return ret;
+}
+
+/// Runs the posted tasks on the js thread, in a single handle scope.
+/// Must be called in the context. Returns the number of tasks which ran.
+/// C++ exceptions thrown by tasks are reported to the exception handler.
+/// Tasks posted while it runs are left for the next call if `max_tasks` is reached.
+extern size_t run_posted_tasks(size_t max_tasks = size_t(-1));
+
+struct post_queue_stats
+{
+    uint64_t depth; // tasks waiting to run
+    uint64_t posted; // since initialization
+    histogram::snapshot wait_us; // time between post and run
+};
+
+/// Can be called from any thread.
+/// The wait time histogram is of the tasks since initialization or since the last rolled snapshot.
+extern post_queue_stats get_post_queue_stats(bool roll = false);
+
+namespace internal
+{
+    // drops the tasks left at deinitialization and on node, sets up the event loop to run them
+    extern void initialize_posted_tasks();
+}
+
+}
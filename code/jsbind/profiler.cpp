@@ -0,0 +1,239 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "profiler.hpp"
+
+#if defined(JSBIND_V8)
+#   include "jsbind/v8/global.hpp"
+#   include "jsbind/common/deinitializers.hpp"
+#   include <v8-profiler.h>
+#   include <fstream>
+#   include <sstream>
+#endif
+
+namespace jsbind
+{
+
+#if defined(JSBIND_V8)
+
+using namespace internal;
+
+namespace
+{
+
+v8::CpuProfiler* cpu_profiler = nullptr;
+std::string profile_name;
+bool deinitializer_added = false;
+
+void write_json_string(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (auto p = str; p && *p; ++p)
+    {
+        auto c = *p;
+        switch (c)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (uint8_t(c) < 0x20)
+            {
+                static const char hex[] = "0123456789abcdef";
+                out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+            }
+            else
+            {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void write_nodes(std::ostream& out, const v8::CpuProfileNode* node, bool& first)
+{
+    if (!first) out << ',';
+    first = false;
+
+    auto name = node->GetFunctionNameStr();
+    out << "{\"id\":" << node->GetNodeId()
+        << ",\"callFrame\":{\"functionName\":";
+    write_json_string(out, name && *name ? name : "(anonymous)");
+    out << ",\"scriptId\":\"" << node->GetScriptId() << "\",\"url\":";
+    write_json_string(out, node->GetScriptResourceNameStr());
+    // devtools lines and columns are zero based
+    out << ",\"lineNumber\":" << node->GetLineNumber() - 1
+        << ",\"columnNumber\":" << node->GetColumnNumber() - 1
+        << "},\"hitCount\":" << node->GetHitCount();
+
+    const int num_children = node->GetChildrenCount();
+    if (num_children)
+    {
+        out << ",\"children\":[";
+        for (int i = 0; i < num_children; ++i)
+        {
+            if (i) out << ',';
+            out << node->GetChild(i)->GetNodeId();
+        }
+        out << ']';
+    }
+    out << '}';
+
+    for (int i = 0; i < num_children; ++i)
+    {
+        write_nodes(out, node->GetChild(i), first);
+    }
+}
+
+void write_profile(std::ostream& out, const v8::CpuProfile* profile)
+{
+    out << "{\"nodes\":[";
+    bool first = true;
+    write_nodes(out, profile->GetTopDownRoot(), first);
+
+    out << "],\"startTime\":" << profile->GetStartTime()
+        << ",\"endTime\":" << profile->GetEndTime()
+        << ",\"samples\":[";
+
+    const int num_samples = profile->GetSamplesCount();
+    for (int i = 0; i < num_samples; ++i)
+    {
+        if (i) out << ',';
+        out << profile->GetSample(i)->GetNodeId();
+    }
+
+    out << "],\"timeDeltas\":[";
+    auto last = profile->GetStartTime();
+    for (int i = 0; i < num_samples; ++i)
+    {
+        if (i) out << ',';
+        auto time = profile->GetSampleTimestamp(i);
+        out << time - last;
+        last = time;
+    }
+    out << "]}";
+}
+
+void dispose_profiler()
+{
+    if (cpu_profiler)
+    {
+        cpu_profiler->Dispose();
+        cpu_profiler = nullptr;
+    }
+}
+
+void deinitialize_profiler()
+{
+    dispose_profiler();
+    deinitializer_added = false;
+}
+
+bool stop_profile(std::ostream& out)
+{
+    if (!cpu_profiler) return false;
+
+    v8::HandleScope scope(isolate);
+    auto title = v8::String::NewFromUtf8(isolate, profile_name.c_str(), v8::NewStringType::kNormal).ToLocalChecked();
+    auto profile = cpu_profiler->StopProfiling(title);
+
+    // the profile belongs to the profiler, so it's disposed of last
+    if (profile)
+    {
+        write_profile(out, profile);
+        profile->Delete();
+    }
+    dispose_profiler();
+
+    return !!profile;
+}
+
+}
+
+namespace profiler
+{
+
+bool start(const char* name, int sampling_interval_us)
+{
+    if (cpu_profiler) return false;
+
+    v8::HandleScope scope(isolate);
+
+    cpu_profiler = v8::CpuProfiler::New(isolate);
+    cpu_profiler->SetSamplingInterval(sampling_interval_us);
+    profile_name = name;
+
+    auto title = v8::String::NewFromUtf8(isolate, name, v8::NewStringType::kNormal).ToLocalChecked();
+    cpu_profiler->StartProfiling(title, true);
+
+    // once for all the profiles of an initialization
+    if (!deinitializer_added)
+    {
+        add_deinitializer(deinitialize_profiler);
+        deinitializer_added = true;
+    }
+    return true;
+}
+
+std::string stop()
+{
+    std::ostringstream out;
+    stop_profile(out);
+    return out.str();
+}
+
+bool stop(const char* path)
+{
+    auto json = stop();
+    if (json.empty()) return false;
+
+    std::ofstream out(path, std::ios::binary);
+    out << json;
+    return out.good();
+}
+
+bool is_running()
+{
+    return !!cpu_profiler;
+}
+
+}
+
+#else
+
+namespace profiler
+{
+
+bool start(const char*, int)
+{
+    return false;
+}
+
+std::string stop()
+{
+    return std::string();
+}
+
+bool stop(const char*)
+{
+    return false;
+}
+
+bool is_running()
+{
+    return false;
+}
+
+}
+
+#endif
+
+}
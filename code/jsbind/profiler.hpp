@@ -0,0 +1,38 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include <string>
+
+namespace jsbind
+{
+
+/// Sampling cpu profiler of the js code, including the bound C++ functions (labelled with their js names).
+/// The profiles are in the .cpuprofile format of Chrome DevTools (Performance > Load profile).
+///
+///     jsbind::profiler::start("frame");
+///     ...
+///     jsbind::profiler::stop("frame.cpuprofile");
+///
+/// Must be called in the context. Only v8 has a profiler. Elsewhere `start` returns false.
+namespace profiler
+{
+    /// Starts a profile. Returns false if a profile is already running or profiling is not supported.
+    extern bool start(const char* name, int sampling_interval_us = 1000);
+
+    /// Stops the current profile and returns it as json (empty if no profile was running).
+    extern std::string stop();
+
+    /// Stops the current profile and writes it to a file. Returns false if nothing was written.
+    extern bool stop(const char* path);
+
+    extern bool is_running();
+}
+
+}
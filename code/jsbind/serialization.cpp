@@ -0,0 +1,302 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "serialization.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include "jsbind/common/deinitializers.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace jsbind::internal;
+
+namespace
+{
+
+#if defined(JSBIND_V8)
+
+struct v8_deleter
+{
+    v8::ArrayBuffer::Contents::DeleterCallback callback;
+    void* data;
+};
+
+// takes the memory of a js array buffer and detaches it
+backing_store* take_contents(v8::Local<v8::ArrayBuffer> buf)
+{
+    if (buf->IsExternal() || !buf->IsDetachable())
+    {
+        // someone else owns the memory, so it can only be copied
+        auto contents = buf->GetContents();
+        auto store = backing_store::allocate(contents.ByteLength());
+        memcpy(store->data(), contents.Data(), contents.ByteLength());
+        if (buf->IsDetachable())
+        {
+            buf->Detach();
+        }
+        return store;
+    }
+
+    auto contents = buf->Externalize();
+    buf->Detach();
+
+    auto deleter = new v8_deleter{ contents.Deleter(), contents.DeleterData() };
+    return backing_store::wrap(reinterpret_cast<uint8_t*>(contents.Data()), contents.ByteLength(),
+        [](uint8_t* data, size_t size, void* d) {
+            auto deleter = reinterpret_cast<v8_deleter*>(d);
+            deleter->callback(data, size, deleter->data);
+            delete deleter;
+        }, deleter);
+}
+
+#else
+
+// a binary encoder for engines with no serializer of their own
+// numbers are little endian and strings are utf-16
+const char* const codec_src = R"js(
+(function () {
+    var UNDEFINED = 0, NULL = 1, FALSE = 2, TRUE = 3, NUMBER = 4, STRING = 5,
+        ARRAY = 6, OBJECT = 7, BUFFER = 8, VIEW = 9, DATE = 10, REF = 11;
+    var views = [Int8Array, Uint8Array, Uint8ClampedArray, Int16Array, Uint16Array,
+        Int32Array, Uint32Array, Float32Array, Float64Array];
+
+    function encode(value) {
+        var buf = new ArrayBuffer(1024), dv = new DataView(buf), pos = 0, seen = new Map();
+        function reserve(n) {
+            if (pos + n <= buf.byteLength) return;
+            var grown = new ArrayBuffer(Math.max(buf.byteLength * 2, pos + n));
+            new Uint8Array(grown).set(new Uint8Array(buf, 0, pos));
+            buf = grown;
+            dv = new DataView(buf);
+        }
+        function u8(v) { reserve(1); dv.setUint8(pos, v); pos += 1; }
+        function u32(v) { reserve(4); dv.setUint32(pos, v, true); pos += 4; }
+        function f64(v) { reserve(8); dv.setFloat64(pos, v, true); pos += 8; }
+        function str(s) {
+            u32(s.length);
+            reserve(s.length * 2);
+            for (var i = 0; i < s.length; ++i, pos += 2) dv.setUint16(pos, s.charCodeAt(i), true);
+        }
+        function bytes(b, offset, length) {
+            u32(length);
+            reserve(length);
+            new Uint8Array(buf, pos, length).set(new Uint8Array(b, offset, length));
+            pos += length;
+        }
+        function write(v) {
+            if (v === undefined) return u8(UNDEFINED);
+            if (v === null) return u8(NULL);
+            if (v === false) return u8(FALSE);
+            if (v === true) return u8(TRUE);
+            var t = typeof v;
+            if (t === 'number') { u8(NUMBER); return f64(v); }
+            if (t === 'string') { u8(STRING); return str(v); }
+            if (t !== 'object') throw new Error('jsbind: ' + t + ' could not be cloned');
+            if (seen.has(v)) { u8(REF); return u32(seen.get(v)); }
+            seen.set(v, seen.size);
+            if (v instanceof ArrayBuffer) { u8(BUFFER); return bytes(v, 0, v.byteLength); }
+            if (v instanceof Date) { u8(DATE); return f64(v.getTime()); }
+            if (ArrayBuffer.isView(v)) {
+                var type = views.indexOf(v.constructor);
+                if (type < 0) throw new Error('jsbind: ' + v.constructor.name + ' could not be cloned');
+                u8(VIEW); u8(type);
+                return bytes(v.buffer, v.byteOffset, v.byteLength);
+            }
+            if (Array.isArray(v)) {
+                u8(ARRAY); u32(v.length);
+                for (var i = 0; i < v.length; ++i) write(v[i]);
+                return;
+            }
+            var keys = Object.keys(v);
+            u8(OBJECT); u32(keys.length);
+            for (var k = 0; k < keys.length; ++k) { str(keys[k]); write(v[keys[k]]); }
+        }
+        write(value);
+        return [buf, pos];
+    }
+
+    function decode(buf) {
+        var dv = new DataView(buf), pos = 0, objs = [];
+        function u8() { return dv.getUint8(pos++); }
+        function u32() { var v = dv.getUint32(pos, true); pos += 4; return v; }
+        function f64() { var v = dv.getFloat64(pos, true); pos += 8; return v; }
+        function str() {
+            var n = u32(), s = '';
+            for (var i = 0; i < n; i += 4096) {
+                var chunk = [], end = Math.min(n, i + 4096);
+                for (var j = i; j < end; ++j, pos += 2) chunk.push(dv.getUint16(pos, true));
+                s += String.fromCharCode.apply(null, chunk);
+            }
+            return s;
+        }
+        function bytes() { var n = u32(), b = buf.slice(pos, pos + n); pos += n; return b; }
+        function keep(o) { objs.push(o); return o; }
+        function read() {
+            var tag = u8(), i, n, o;
+            switch (tag) {
+            case UNDEFINED: return undefined;
+            case NULL: return null;
+            case FALSE: return false;
+            case TRUE: return true;
+            case NUMBER: return f64();
+            case STRING: return str();
+            case REF: return objs[u32()];
+            case BUFFER: return keep(bytes());
+            case DATE: return keep(new Date(f64()));
+            case VIEW: o = views[u8()]; return keep(new o(bytes()));
+            case ARRAY:
+                n = u32(); o = keep(new Array(n));
+                for (i = 0; i < n; ++i) o[i] = read();
+                return o;
+            case OBJECT:
+                n = u32(); o = keep({});
+                for (i = 0; i < n; ++i) { var key = str(); o[key] = read(); }
+                return o;
+            }
+            throw new Error('jsbind: corrupt serialized value');
+        }
+        return read();
+    }
+
+    return { encode: encode, decode: decode };
+})()
+)js";
+
+jsbind::persistent codec;
+
+void clear_codec()
+{
+    codec.reset();
+}
+
+jsbind::local get_codec()
+{
+    if (codec.is_empty())
+    {
+        codec.reset(jsbind::local::global("eval")(codec_src));
+        add_deinitializer(clear_codec);
+    }
+
+    return codec.to_local();
+}
+
+#endif
+
+}
+
+namespace jsbind
+{
+
+#if defined(JSBIND_V8)
+
+serialized_value serialize(const local& value, const std::vector<local>& transfer)
+{
+    serialized_value ret;
+
+    v8::HandleScope scope(isolate);
+    v8::TryCatch try_catch(isolate);
+
+    // no delegate, so that v8 throws its own DataCloneError for values which can't be cloned
+    v8::ValueSerializer serializer(isolate);
+
+    std::vector<v8::Local<v8::ArrayBuffer>> buffers;
+    for (auto& t : transfer)
+    {
+        assert(t.m_handle->IsArrayBuffer() && "only array buffers can be transferred");
+        auto buf = v8::Local<v8::ArrayBuffer>::Cast(t.m_handle);
+        serializer.TransferArrayBuffer(uint32_t(buffers.size()), buf);
+        buffers.push_back(buf);
+    }
+
+    serializer.WriteHeader();
+    if (serializer.WriteValue(ctx.to_local(), value.m_handle).IsNothing())
+    {
+        report_exception(try_catch);
+        return ret;
+    }
+
+    for (auto& buf : buffers)
+    {
+        ret.m_transferred.push_back(take_contents(buf));
+    }
+
+    auto bytes = serializer.Release();
+    ret.m_data.assign(bytes.first, bytes.first + bytes.second);
+    free(bytes.first);
+
+    return ret;
+}
+
+local deserialize(const serialized_value& value)
+{
+    v8::EscapableHandleScope scope(isolate);
+    v8::TryCatch try_catch(isolate);
+
+    auto& data = value.data();
+    v8::ValueDeserializer deserializer(isolate, data.data(), data.size());
+
+    uint32_t id = 0;
+    for (auto store : value.transferred())
+    {
+        auto buf = make_external_array_buffer(store->data(), store->size(), new backing_store_ref(store));
+        deserializer.TransferArrayBuffer(id++, v8::Local<v8::ArrayBuffer>::Cast(buf.m_handle));
+    }
+
+    v8::Local<v8::Value> result;
+    if (deserializer.ReadHeader(ctx.to_local()).IsNothing()
+        || !deserializer.ReadValue(ctx.to_local()).ToLocal(&result))
+    {
+        report_exception(try_catch);
+        return local::undefined();
+    }
+
+    return local(scope.Escape(result));
+}
+
+#else
+
+// the fallback copies transferred buffers into the bytes, as not all engines can detach them
+serialized_value serialize(const local& value, const std::vector<local>& /*transfer*/)
+{
+    serialized_value ret;
+
+    auto encoded = get_codec().call<local>("encode", value);
+    if (encoded.isUndefined())
+    {
+        // the exception is already reported
+        return ret;
+    }
+
+    ret.m_data = array_buffer_contents(encoded[0]);
+    ret.m_data.resize(encoded[1].as<uint32_t>());
+
+    return ret;
+}
+
+local deserialize(const serialized_value& value)
+{
+    auto& data = value.data();
+    auto store = backing_store::allocate(data.size());
+    if (!data.empty())
+    {
+        memcpy(store->data(), data.data(), data.size());
+    }
+
+    auto buf = make_external_array_buffer(store->data(), store->size(), new backing_store_ref(store));
+    store->release();
+
+    return get_codec().call<local>("decode", buf);
+}
+
+#endif
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "shared_memory_extension.hpp"
+
+#include <vector>
+#include <cstdint>
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+namespace jsbind
+{
+
+/// A js value serialized to bytes, to be deserialized in another context or isolate.
+///
+/// On v8 the bytes are the ones of `v8::ValueSerializer` (the structured clone algorithm).
+/// Elsewhere they come from a binary encoder in js which supports undefined, null, booleans,
+/// numbers, strings, arrays, plain objects, dates, array buffers and typed arrays, including
+/// cyclic references.
+///
+/// Transferred array buffers are not part of the bytes. Their memory is moved out of js into
+/// the serialized value, and moved into the js buffers created by `deserialize`.
+class serialized_value
+{
+public:
+    serialized_value() = default;
+
+    // bytes produced by `serialize`, received from elsewhere (with no transferred buffers)
+    explicit serialized_value(std::vector<uint8_t> data)
+        : m_data(std::move(data))
+    {}
+
+    serialized_value(serialized_value&& other)
+        : m_data(std::move(other.m_data))
+        , m_transferred(std::move(other.m_transferred))
+    {
+        other.m_transferred.clear();
+    }
+
+    serialized_value& operator=(serialized_value&& other)
+    {
+        clear_transferred();
+        m_data = std::move(other.m_data);
+        m_transferred = std::move(other.m_transferred);
+        other.m_transferred.clear();
+        return *this;
+    }
+
+    serialized_value(const serialized_value&) = delete;
+    serialized_value& operator=(const serialized_value&) = delete;
+
+    ~serialized_value()
+    {
+        clear_transferred();
+    }
+
+    // empty when serialization failed
+    bool empty() const { return m_data.empty(); }
+
+    const std::vector<uint8_t>& data() const { return m_data; }
+
+    const std::vector<internal::backing_store*>& transferred() const { return m_transferred; }
+
+private:
+    friend serialized_value serialize(const local& value, const std::vector<local>& transfer);
+
+    void clear_transferred()
+    {
+        for (auto store : m_transferred)
+        {
+            store->release();
+        }
+        m_transferred.clear();
+    }
+
+    std::vector<uint8_t> m_data;
+    std::vector<internal::backing_store*> m_transferred;
+};
+
+/// Serializes a js value.
+/// The array buffers in `transfer` are moved instead of copied and are detached where the engine allows it.
+/// On failure the error is reported to the exception handler and the result is empty.
+extern serialized_value serialize(const local& value, const std::vector<local>& transfer = std::vector<local>());
+
+/// Creates a js value from serialized bytes.
+/// The js buffers of transferred array buffers share their memory with the serialized value,
+/// so each serialized value with transfers should be deserialized once.
+/// On failure the error is reported to the exception handler and the result is undefined.
+extern local deserialize(const serialized_value& value);
+
+}
+
+#endif
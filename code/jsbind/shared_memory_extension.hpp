@@ -1,6 +1,8 @@
 #pragma once
 
 #include "value.hpp"
+#include "jsbind/common/typed_array_traits.hpp"
+#include "jsbind/common/wrapped_class.hpp"
 
 #if defined(JSBIND_V8)
 #elif defined(JSBIND_JSC)
@@ -13,42 +15,509 @@
 #endif
 
 #include <cstdint>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <cstring>
+#include <cassert>
 
 namespace jsbind
 {
 
 namespace internal
 {
+// owner of memory which has been handed over to the js engine
+// it's destroyed by the engine's finalizer once the js object is collected
+struct external_storage
+{
+    virtual ~external_storage() {}
+};
+
+template <typename T, typename Alloc = std::allocator<T>>
+struct vector_storage : public external_storage
+{
+    std::vector<T, Alloc> vec;
+};
+
+template <typename T>
+struct array_storage : public external_storage
+{
+    std::unique_ptr<T[]> ptr;
+};
+
+// refcounted memory shared between c++ buffers and js array buffers
+// it's released only after both the c++ side and the js gc are done with it
+class backing_store
+{
+public:
+    typedef void(*deleter_func)(uint8_t* data, size_t size, void* deleter_data);
+
+    // allocates memory which is freed with delete[]
+    // the returned store has a single reference owned by the caller
+    static backing_store* allocate(size_t size)
+    {
+        return new backing_store(new uint8_t[size], size, [](uint8_t* data, size_t, void*) {
+            delete[] data;
+        }, nullptr);
+    }
+
+    // wraps external memory
+    // without a deleter the lifetime of the memory is the caller's responsibility
+    static backing_store* wrap(uint8_t* data, size_t size, deleter_func deleter = nullptr, void* deleter_data = nullptr)
+    {
+        return new backing_store(data, size, deleter, deleter_data);
+    }
+
+    void add_ref()
+    {
+        m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // adds a reference unless the store is already being destroyed
+    // used by caches which hold stores without referencing them
+    bool try_add_ref()
+    {
+        auto refs = m_refs.load(std::memory_order_relaxed);
+        while (refs)
+        {
+            if (m_refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release()
+    {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    size_t use_count() const { return m_refs.load(std::memory_order_relaxed); }
+
+private:
+    backing_store(uint8_t* data, size_t size, deleter_func deleter, void* deleter_data)
+        : m_refs(1)
+        , m_data(data)
+        , m_size(size)
+        , m_deleter(deleter)
+        , m_deleter_data(deleter_data)
+    {}
+
+    ~backing_store()
+    {
+        if (m_deleter)
+        {
+            m_deleter(m_data, m_size, m_deleter_data);
+        }
+    }
+
+    std::atomic<size_t> m_refs;
+    uint8_t* m_data;
+    size_t m_size;
+    deleter_func m_deleter;
+    void* m_deleter_data;
+};
+
+// the reference to a backing store held by a js object
+struct backing_store_ref : public external_storage
+{
+    explicit backing_store_ref(backing_store* s)
+        : store(s)
+    {
+        store->add_ref();
+    }
+
+    ~backing_store_ref()
+    {
+        drop();
+    }
+
+    void drop()
+    {
+        if (store)
+        {
+            store->release();
+            store = nullptr;
+        }
+    }
+
+    backing_store* store;
+};
+
+// a counted reference to a backing store, which keeps its memory alive
+class backing_store_ptr
+{
+public:
+    backing_store_ptr() = default;
+
+    explicit backing_store_ptr(backing_store* store)
+        : m_store(store)
+    {
+        if (m_store) m_store->add_ref();
+    }
+
+    backing_store_ptr(const backing_store_ptr& other)
+        : backing_store_ptr(other.m_store)
+    {}
+
+    backing_store_ptr(backing_store_ptr&& other)
+        : m_store(other.m_store)
+    {
+        other.m_store = nullptr;
+    }
+
+    backing_store_ptr& operator=(backing_store_ptr other)
+    {
+        std::swap(m_store, other.m_store);
+        return *this;
+    }
+
+    ~backing_store_ptr()
+    {
+        if (m_store) m_store->release();
+    }
+
+    backing_store* get() const { return m_store; }
+    backing_store* operator->() const { return m_store; }
+    explicit operator bool() const { return !!m_store; }
+
+    bool operator==(const backing_store_ptr& other) const { return m_store == other.m_store; }
+    bool operator!=(const backing_store_ptr& other) const { return m_store != other.m_store; }
+
+private:
+    backing_store* m_store = nullptr;
+};
+}
+
+#if defined(JSBIND_V8)
+namespace internal
+{
+struct external_array_buffer_finalizer
+{
+    v8::Persistent<v8::Object> handle;
+    external_storage* storage;
+    size_t size;
+
+    static void track(v8::Local<v8::Object> obj, external_storage* storage, size_t size)
+    {
+        auto f = new external_array_buffer_finalizer;
+        f->handle.Reset(isolate, obj);
+        f->handle.SetWeak(f, on_collected, v8::WeakCallbackType::kParameter);
+        f->storage = storage;
+        f->size = size;
+        isolate->AdjustAmountOfExternalAllocatedMemory(int64_t(size));
+    }
+
+    static void on_collected(const v8::WeakCallbackInfo<external_array_buffer_finalizer>& info)
+    {
+        auto f = info.GetParameter();
+        f->handle.Reset();
+        isolate->AdjustAmountOfExternalAllocatedMemory(-int64_t(f->size));
+        delete f->storage;
+        delete f;
+    }
+};
+}
+#elif defined(JSBIND_JSC)
+namespace internal
+{
+inline JSTypedArrayType to_jsc_typed_array_type(typed_array_type type)
+{
+    switch (type)
+    {
+    case typed_array_type::int8: return kJSTypedArrayTypeInt8Array;
+    case typed_array_type::uint8: return kJSTypedArrayTypeUint8Array;
+    case typed_array_type::int16: return kJSTypedArrayTypeInt16Array;
+    case typed_array_type::uint16: return kJSTypedArrayTypeUint16Array;
+    case typed_array_type::int32: return kJSTypedArrayTypeInt32Array;
+    case typed_array_type::uint32: return kJSTypedArrayTypeUint32Array;
+    case typed_array_type::float32: return kJSTypedArrayTypeFloat32Array;
+    case typed_array_type::float64: return kJSTypedArrayTypeFloat64Array;
+    default:
+        assert(false && "no typed array for type");
+        return kJSTypedArrayTypeNone;
+    }
+}
+
+inline typed_array_type from_jsc_typed_array_type(JSTypedArrayType type)
+{
+    switch (type)
+    {
+    case kJSTypedArrayTypeInt8Array: return typed_array_type::int8;
+    case kJSTypedArrayTypeUint8Array:
+    case kJSTypedArrayTypeUint8ClampedArray: return typed_array_type::uint8;
+    case kJSTypedArrayTypeInt16Array: return typed_array_type::int16;
+    case kJSTypedArrayTypeUint16Array: return typed_array_type::uint16;
+    case kJSTypedArrayTypeInt32Array: return typed_array_type::int32;
+    case kJSTypedArrayTypeUint32Array: return typed_array_type::uint32;
+    case kJSTypedArrayTypeFloat32Array: return typed_array_type::float32;
+    case kJSTypedArrayTypeFloat64Array: return typed_array_type::float64;
+    default: return typed_array_type::none;
+    }
+}
+}
+#elif defined(JSBIND_CEF)
+namespace internal
+{
+class release_buffer_callback : public CefV8ArrayBufferReleaseCallback
+{
+public:
+    explicit release_buffer_callback(external_storage* storage = nullptr)
+        : m_storage(storage)
+    {}
+
+    virtual void ReleaseBuffer(void*) override
+    {
+        delete m_storage;
+        m_storage = nullptr;
+    }
+
+private:
+    external_storage* m_storage;
+    IMPLEMENT_REFCOUNTING(release_buffer_callback)
+};
+}
+#endif
+
+#if !defined(JSBIND_EMSCRIPTEN)
+namespace internal
+{
+// creates an array buffer over external memory
+// the storage (if any) is deleted when the array buffer is collected
+inline local make_external_array_buffer(void* data, size_t size, external_storage* storage)
+{
+#if defined(JSBIND_NOOP_TYPED_ARRAYS)
+    delete storage;
+    return local::null();
+#elif defined(JSBIND_V8)
+    auto obj = v8::ArrayBuffer::New(isolate, data, size);
+    if (storage)
+    {
+        external_array_buffer_finalizer::track(obj, storage, size);
+    }
+    return local(obj);
+#elif defined(JSBIND_JSC)
+    return local(JSValueRef(JSObjectMakeArrayBufferWithBytesNoCopy(jsc_context,
+        data, size, [](void*, void* s) {
+            delete reinterpret_cast<external_storage*>(s);
+        }, storage, nullptr)));
+#elif defined(JSBIND_CEF)
+    return local(CefV8Value::CreateArrayBuffer(data, size, new release_buffer_callback(storage)));
+#endif
+}
+
+// creates a SharedArrayBuffer over external memory
+// engines which can't share array buffers (or have no public api for it) get an ArrayBuffer
+inline local make_external_shared_array_buffer(void* data, size_t size, external_storage* storage)
+{
+#if defined(JSBIND_V8) && !defined(JSBIND_NOOP_TYPED_ARRAYS)
+    auto obj = v8::SharedArrayBuffer::New(isolate, data, size);
+    if (storage)
+    {
+        external_array_buffer_finalizer::track(obj, storage, size);
+    }
+    return local(obj);
+#else
+    return make_external_array_buffer(data, size, storage);
+#endif
+}
+
+// creates a typed array over a whole array buffer
+inline local make_typed_array_view(typed_array_type type, const local& array_buffer)
+{
+#if defined(JSBIND_NOOP_TYPED_ARRAYS)
+    (void)type; (void)array_buffer;
+    return local::null();
+#elif defined(JSBIND_V8)
+    auto buf = v8::Local<v8::ArrayBuffer>::Cast(array_buffer.m_handle);
+    auto length = buf->ByteLength() / typed_array_element_size(type);
+    switch (type)
+    {
+    case typed_array_type::int8: return local(v8::Int8Array::New(buf, 0, length));
+    case typed_array_type::uint8: return local(v8::Uint8Array::New(buf, 0, length));
+    case typed_array_type::int16: return local(v8::Int16Array::New(buf, 0, length));
+    case typed_array_type::uint16: return local(v8::Uint16Array::New(buf, 0, length));
+    case typed_array_type::int32: return local(v8::Int32Array::New(buf, 0, length));
+    case typed_array_type::uint32: return local(v8::Uint32Array::New(buf, 0, length));
+    case typed_array_type::float32: return local(v8::Float32Array::New(buf, 0, length));
+    case typed_array_type::float64: return local(v8::Float64Array::New(buf, 0, length));
+    default:
+        assert(false && "no typed array for type");
+        return local::undefined();
+    }
+#elif defined(JSBIND_JSC)
+    return local(JSValueRef(JSObjectMakeTypedArrayWithArrayBuffer(jsc_context,
+        to_jsc_typed_array_type(type), array_buffer.as_jsc_object(), nullptr)));
+#elif defined(JSBIND_CEF)
+    return local(make_typed_array_func->ExecuteFunction(nullptr,
+        { array_buffer.m_handle, CefV8Value::CreateString(typed_array_name(type)) }));
+#endif
+}
+
+// creates a typed array of `length` elements over external memory
+// the storage (if any) is deleted when the typed array is collected
+inline local make_external_typed_array(typed_array_type type, void* data, size_t length, external_storage* storage)
+{
+    const size_t size = length * typed_array_element_size(type);
+#if defined(JSBIND_JSC) && !defined(JSBIND_NOOP_TYPED_ARRAYS)
+    return local(JSValueRef(JSObjectMakeTypedArrayWithBytesNoCopy(jsc_context,
+        to_jsc_typed_array_type(type), data, size, [](void*, void* s) {
+            delete reinterpret_cast<external_storage*>(s);
+        }, storage, nullptr)));
+#else
+    return make_typed_array_view(type, make_external_array_buffer(data, size, storage));
+#endif
+}
+
+// the elements of a js typed array, in place
+// returns nullptr if the value isn't a typed array or the backend has no access to its memory
+inline void* typed_array_elements(const local& val, typed_array_type& type, size_t& length)
+{
+    type = typed_array_type::none;
+    length = 0;
+#if defined(JSBIND_NOOP_TYPED_ARRAYS) || defined(JSBIND_CEF)
+    (void)val;
+    return nullptr;
+#elif defined(JSBIND_V8)
+    auto handle = val.m_handle;
+    if (!handle->IsTypedArray()) return nullptr;
+
+    if (handle->IsInt8Array()) type = typed_array_type::int8;
+    else if (handle->IsUint8Array() || handle->IsUint8ClampedArray()) type = typed_array_type::uint8;
+    else if (handle->IsInt16Array()) type = typed_array_type::int16;
+    else if (handle->IsUint16Array()) type = typed_array_type::uint16;
+    else if (handle->IsInt32Array()) type = typed_array_type::int32;
+    else if (handle->IsUint32Array()) type = typed_array_type::uint32;
+    else if (handle->IsFloat32Array()) type = typed_array_type::float32;
+    else if (handle->IsFloat64Array()) type = typed_array_type::float64;
+    else return nullptr; // bigint arrays
+
+    auto view = v8::Local<v8::TypedArray>::Cast(handle);
+    v8::Local<v8::Value> buf = view->Buffer();
+    auto data = buf->IsSharedArrayBuffer() ?
+        v8::SharedArrayBuffer::Cast(*buf)->GetContents().Data() :
+        v8::ArrayBuffer::Cast(*buf)->GetContents().Data();
+
+    length = view->Length();
+    return reinterpret_cast<uint8_t*>(data) + view->ByteOffset();
+#elif defined(JSBIND_JSC) && defined(_JSC_TYPED_ARRAYS)
+    JSTypedArrayType jsc_type;
+    auto data = jsc_typed_array_elements(val.m_handle, jsc_type, length);
+    type = from_jsc_typed_array_type(jsc_type);
+    return data;
+#else
+    (void)val;
+    return nullptr;
+#endif
+}
+
+// copies the contents of a js array buffer
+inline std::vector<uint8_t> array_buffer_contents(const local& array_buffer)
+{
+    std::vector<uint8_t> ret;
+#if defined(JSBIND_NOOP_TYPED_ARRAYS)
+    (void)array_buffer;
+#elif defined(JSBIND_V8)
+    auto contents = v8::ArrayBuffer::Cast(*array_buffer.m_handle)->GetContents();
+    auto data = reinterpret_cast<const uint8_t*>(contents.Data());
+    ret.assign(data, data + contents.ByteLength());
+#elif defined(JSBIND_JSC)
+    auto obj = JSValueToObject(jsc_context, array_buffer.m_handle, nullptr);
+    auto data = reinterpret_cast<const uint8_t*>(JSObjectGetArrayBufferBytesPtr(jsc_context, obj, nullptr));
+    ret.assign(data, data + JSObjectGetArrayBufferByteLength(jsc_context, obj, nullptr));
+#elif defined(JSBIND_CEF)
+    // cef has no access to the bytes of array buffers, so they come as one string instead of a call per byte
+    CefString chars = array_buffer_chars_func->ExecuteFunction(nullptr, { array_buffer.m_handle })->GetStringValue();
+    auto p = chars.c_str();
+    ret.resize(chars.length());
+    for (size_t i = 0; i < ret.size(); ++i)
+    {
+        ret[i] = uint8_t(p[i]);
+    }
+#endif
+    return ret;
+}
+
+// copies `length` bytes of a js array buffer, starting at `offset`, straight to `out`
+inline void copy_array_buffer(const local& array_buffer, size_t offset, size_t length, void* out)
+{
+    auto dst = reinterpret_cast<uint8_t*>(out);
+#if defined(JSBIND_NOOP_TYPED_ARRAYS)
+    (void)array_buffer; (void)offset; (void)length; (void)dst;
+#elif defined(JSBIND_V8)
+    auto contents = v8::ArrayBuffer::Cast(*array_buffer.m_handle)->GetContents();
+    assert(offset + length <= contents.ByteLength());
+    memcpy(dst, reinterpret_cast<const uint8_t*>(contents.Data()) + offset, length);
+#elif defined(JSBIND_JSC)
+    auto obj = JSValueToObject(jsc_context, array_buffer.m_handle, nullptr);
+    assert(offset + length <= JSObjectGetArrayBufferByteLength(jsc_context, obj, nullptr));
+    auto data = reinterpret_cast<const uint8_t*>(JSObjectGetArrayBufferBytesPtr(jsc_context, obj, nullptr));
+    memcpy(dst, data + offset, length);
+#elif defined(JSBIND_CEF)
+    CefString chars = array_buffer_chars_func->ExecuteFunction(nullptr, { array_buffer.m_handle,
+        CefV8Value::CreateUInt(uint32_t(offset)), CefV8Value::CreateUInt(uint32_t(length)) })->GetStringValue();
+    assert(chars.length() == length);
+    auto p = chars.c_str();
+    for (size_t i = 0; i < length; ++i)
+    {
+        dst[i] = uint8_t(p[i]);
+    }
+#endif
+}
+}
+#endif
+
+namespace internal
+{
+// c++ side of a js buffer object
+// the memory is held by a backing store which is referenced both by this object
+// and by the js object (through the engine's finalizer), so either can outlive the other
+//
+// on emscripten the js objects are views of the heap, so their memory is valid only
+// while the c++ buffer is alive
 template <typename T>
 class buffer
 {
 public:
     buffer(size_t size)
-        : m_size(size)
-        , m_buffer(new uint8_t[size])
-        , m_owner(true)
     {
-        static_cast<T*>(this)->init();
+        attach(backing_store::allocate(size));
     }
 
+    // the memory is not owned and must outlive both the c++ and js objects
     buffer(uint8_t* buf, size_t size)
-        : m_size(size)
-        , m_buffer(buf)
-        , m_owner(false)
     {
-        static_cast<T*>(this)->init();
+        attach(backing_store::wrap(buf, size));
+    }
+
+    // shares the memory of an existing store
+    explicit buffer(backing_store* store)
+    {
+        assert(store && "buffer of an empty backing store");
+        store->add_ref();
+        attach(store);
     }
 
     buffer(buffer&& other)
         : m_size(other.m_size)
         , m_buffer(other.m_buffer)
         , m_persistent(std::move(other.m_persistent))
-        , m_owner(other.m_owner)
+        , m_store(other.m_store)
+        , m_js_ref(other.m_js_ref)
     {
         other.m_size = 0;
         other.m_buffer = nullptr;
         other.m_persistent.reset();
-        other.m_owner = true;
+        other.m_store = nullptr;
+        other.m_js_ref = nullptr;
     }
 
     buffer(const buffer&) = delete;
@@ -56,9 +525,10 @@ public:
 
     ~buffer()
     {
-        if (m_owner)
+        m_persistent.reset();
+        if (m_store)
         {
-            delete[] m_buffer;
+            m_store->release();
         }
     }
 
@@ -69,48 +539,111 @@ public:
 
     const persistent& get_persistent() const { return m_persistent; }
 
+    // empty for moved-from and transferred buffers
+    backing_store_ptr get_backing_store() const { return backing_store_ptr(m_store); }
+
+    // detaches the js object from the memory
+    // js sees an empty buffer afterwards and no longer keeps the memory alive
+    // returns false if the backend can't detach buffers, in which case the js
+    // object stays valid and keeps its reference
+    bool detach()
+    {
+        if (m_persistent.is_empty()) return true;
+
+#if defined(JSBIND_NOOP_TYPED_ARRAYS) || defined(JSBIND_EMSCRIPTEN) || defined(JSBIND_JSC)
+        // there is no way to detach an array buffer
+        return false;
+#else
+#   if defined(JSBIND_V8)
+        auto handle = m_persistent.to_local().m_handle;
+        auto ab = handle->IsArrayBufferView() ?
+            v8::Local<v8::ArrayBufferView>::Cast(handle)->Buffer() :
+            v8::Local<v8::ArrayBuffer>::Cast(handle);
+        if (!ab->IsDetachable()) return false;
+        ab->Detach();
+#   elif defined(JSBIND_CEF)
+        auto handle = m_persistent.to_local().m_handle;
+        auto ab = handle->IsArrayBuffer() ? handle : handle->GetValue("buffer");
+        if (!ab->NeuterArrayBuffer()) return false;
+#   endif
+        m_persistent.reset();
+        if (m_js_ref)
+        {
+            m_js_ref->drop();
+            m_js_ref = nullptr;
+        }
+        return true;
+#endif
+    }
+
+    // moves the memory to a new buffer and a new js object
+    // the current js object is detached (if the backend supports it) and
+    // this buffer is left empty
+    T transfer()
+    {
+        if (!m_store)
+        {
+            // already moved or transferred, so the result is as empty as this buffer
+            return T(std::move(static_cast<T&>(*this)));
+        }
+
+        detach();
+        T ret(m_store);
+        m_persistent.reset();
+        m_store->release();
+        m_store = nullptr;
+        m_js_ref = nullptr;
+        m_buffer = nullptr;
+        m_size = 0;
+        return ret;
+    }
+
 protected:
-    size_t m_size;
-    uint8_t* m_buffer;
+    // the reference of the js object to the backing store
+    // it's owned by the js engine and lives as long as the js object does
+    external_storage* new_js_ref()
+    {
+#if defined(JSBIND_NOOP_TYPED_ARRAYS) || defined(JSBIND_EMSCRIPTEN)
+        return nullptr;
+#else
+        m_js_ref = new backing_store_ref(m_store);
+        return m_js_ref;
+#endif
+    }
+
+    size_t m_size = 0;
+    uint8_t* m_buffer = nullptr;
     persistent m_persistent;
-    bool m_owner;
-};
-}
+    backing_store* m_store = nullptr;
+    backing_store_ref* m_js_ref = nullptr;
 
-#if defined(JSBIND_CEF)
-namespace internal
-{
-class release_buffer_callback : public CefV8ArrayBufferReleaseCallback
-{
-    virtual void ReleaseBuffer(void*) override {}
-    IMPLEMENT_REFCOUNTING(release_buffer_callback)
+private:
+    void attach(backing_store* store)
+    {
+        m_store = store;
+        m_size = store->size();
+        m_buffer = store->data();
+        static_cast<T*>(this)->init();
+    }
 };
 }
-#endif
 
 class uint8_array : public internal::buffer<uint8_array>
 {
 public:
     uint8_array(size_t size) : buffer(size) {}
     uint8_array(uint8_t* buf, size_t size) : buffer(buf, size) {}
+    explicit uint8_array(internal::backing_store* store) : buffer(store) {}
+    explicit uint8_array(const internal::backing_store_ptr& store) : buffer(store.get()) {}
 
     void init()
     {
-#if defined(JSBIND_NOOP_TYPED_ARRAYS)
-        auto obj = local::null();
-#elif defined(JSBIND_V8)
-        auto arrayBuffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), m_buffer, m_size);
-        auto obj = v8::Uint8Array::New(arrayBuffer, 0, m_size);
-#elif defined(JSBIND_JSC)
-        auto obj = JSValueRef(JSObjectMakeTypedArrayWithBytesNoCopy(internal::jsc_context,
-            kJSTypedArrayTypeUint8Array, m_buffer, m_size, [](void*, void*){}, nullptr, nullptr));
-#elif defined(JSBIND_EMSCRIPTEN)
-        auto obj = emscripten::typed_memory_view(m_size, m_buffer);
-#elif defined(JSBIND_CEF)
-        auto arrayBuf = CefV8Value::CreateArrayBuffer(m_buffer, m_size, new internal::release_buffer_callback);
-        auto obj = internal::make_uint8_array_func->ExecuteFunction(nullptr, { arrayBuf });
+#if defined(JSBIND_EMSCRIPTEN)
+        auto obj = local(emscripten::typed_memory_view(m_size, m_buffer));
+#else
+        auto obj = internal::make_external_typed_array(internal::typed_array_type::uint8, m_buffer, m_size, new_js_ref());
 #endif
-        m_persistent.reset(local(obj));
+        m_persistent.reset(obj);
     }
 };
 
@@ -119,24 +652,295 @@ class array_buffer : public internal::buffer<array_buffer>
 public:
     array_buffer(size_t size) : buffer(size) {}
     array_buffer(uint8_t* buf, size_t size) : buffer(buf, size) {}
+    explicit array_buffer(internal::backing_store* store) : buffer(store) {}
+    explicit array_buffer(const internal::backing_store_ptr& store) : buffer(store.get()) {}
 
     void init()
     {
-#if defined(JSBIND_NOOP_TYPED_ARRAYS)
-        auto obj = local::null();
-#elif defined(JSBIND_V8)
-        auto obj = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), m_buffer, m_size);
-#elif defined(JSBIND_JSC)
-        auto obj = JSValueRef(JSObjectMakeTypedArrayWithBytesNoCopy(internal::jsc_context,
-            kJSTypedArrayTypeArrayBuffer, m_buffer, m_size, [](void*, void*){}, nullptr, nullptr));
-#elif defined(JSBIND_EMSCRIPTEN)
+#if defined(JSBIND_EMSCRIPTEN)
         auto u8a = local(emscripten::typed_memory_view(m_size, m_buffer));
         auto obj = u8a["buffer"];
-#elif defined(JSBIND_CEF)
-        auto obj = CefV8Value::CreateArrayBuffer(m_buffer, m_size, new internal::release_buffer_callback);
+#else
+        auto obj = internal::make_external_array_buffer(m_buffer, m_size, new_js_ref());
+#endif
+        m_persistent.reset(obj);
+    }
+};
+
+/// Array of numbers which is moved to js as a typed array without copying.
+///
+/// The storage of the vector (or the unique_ptr) is adopted as the backing
+/// store of the js array and is freed by the engine's finalizer when the array
+/// is collected. Return it from bound functions instead of `std::vector<T>`:
+///
+///     jsbind::typed_array<float> get_positions()
+///     {
+///         std::vector<float> ret = ...;
+///         return jsbind::typed_array<float>(std::move(ret));
+///     }
+///
+/// Converting a typed_array to js consumes it. On emscripten the memory can't
+/// be adopted by js, so the data is copied there and the array is left intact.
+template <typename T>
+class typed_array
+{
+public:
+    static_assert(internal::has_typed_array<T>::value, "typed_array: no js typed array can hold this type");
+
+    typed_array(std::vector<T>&& vec)
+    {
+        adopt(std::move(vec));
+    }
+
+    // the allocator frees the storage when the js array is collected
+    template <typename Alloc>
+    typed_array(std::vector<T, Alloc>&& vec)
+    {
+        adopt(std::move(vec));
+    }
+
+    typed_array(std::unique_ptr<T[]> data, size_t size)
+    {
+        auto s = new internal::array_storage<T>;
+        s->ptr = std::move(data);
+        m_data = s->ptr.get();
+        m_size = size;
+        m_storage.reset(s);
+    }
+
+    typed_array(typed_array&& other)
+        : m_storage(std::move(other.m_storage))
+        , m_data(other.m_data)
+        , m_size(other.m_size)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    typed_array(const typed_array&) = delete;
+    typed_array& operator=(const typed_array&) = delete;
+
+    size_t size() const { return m_size; }
+
+    const T* data() const { return m_data; }
+    T* data() { return m_data; }
+
+#if !defined(JSBIND_EMSCRIPTEN)
+    // converters take their arguments by const ref, hence the mutable members
+    local to_local() const
+    {
+        auto data = m_data;
+        auto size = m_size;
+        m_data = nullptr;
+        m_size = 0;
+        return internal::make_external_typed_array(internal::typed_array_traits<T>::type, data, size, m_storage.release());
+    }
 #endif
-        m_persistent.reset(local(obj));
+
+private:
+    template <typename Alloc>
+    void adopt(std::vector<T, Alloc>&& vec)
+    {
+        auto s = new internal::vector_storage<T, Alloc>;
+        s->vec = std::move(vec);
+        m_data = s->vec.data();
+        m_size = s->vec.size();
+        m_storage.reset(s);
     }
+
+    mutable std::unique_ptr<internal::external_storage> m_storage;
+    mutable T* m_data;
+    mutable size_t m_size;
 };
 
+
+#if !defined(JSBIND_EMSCRIPTEN)
+/// A js typed array borrowed by C++ for the duration of a call.
+///
+/// Take it as an argument of a bound function to read or write the elements in place,
+/// without copying them into a vector:
+///
+///     float sum(jsbind::typed_array_view<float> values)
+///     {
+///         return std::accumulate(values.begin(), values.end(), 0.f);
+///     }
+///
+/// The view is empty if the value isn't a typed array of T (a Float32Array for float,
+/// Uint8Array or Uint8ClampedArray for uint8_t, etc). Don't keep it after the call, as the
+/// js array may be collected or detached. CEF has no access to the memory of typed
+/// arrays, so there the view is always empty.
+template <typename T>
+class typed_array_view
+{
+public:
+    static_assert(internal::has_typed_array<T>::value, "typed_array_view: no js typed array can hold this type");
+
+    typed_array_view()
+        : m_data(nullptr)
+        , m_size(0)
+    {}
+
+    typed_array_view(T* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {}
+
+    static typed_array_view from_local(const local& val)
+    {
+        internal::typed_array_type type;
+        size_t length;
+        auto data = internal::typed_array_elements(val, type, length);
+        if (!data || type != internal::typed_array_traits<T>::type)
+        {
+            return typed_array_view();
+        }
+        return typed_array_view(reinterpret_cast<T*>(data), length);
+    }
+
+    T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](size_t i) const { return m_data[i]; }
+
+    T* begin() const { return m_data; }
+    T* end() const { return m_data + m_size; }
+
+    std::vector<T> to_vector() const
+    {
+        return std::vector<T>(begin(), end());
+    }
+
+private:
+    T* m_data;
+    size_t m_size;
+};
+#endif
+
+}
+
+namespace jsbind
+{
+namespace internal
+{
+    template <typename T>
+    struct is_wrapped_class<typed_array<T>> : std::false_type {};
+
+#if !defined(JSBIND_EMSCRIPTEN)
+    template <typename T>
+    struct is_wrapped_class<typed_array_view<T>> : std::false_type {};
+#endif
+
+#if defined(JSBIND_V8)
+    template <typename T>
+    struct convert<typed_array<T>>
+    {
+        using from_type = typed_array<T>;
+        using to_type = v8::Local<v8::Value>;
+
+        static from_type from_v8(v8::Local<v8::Value>) = delete;
+
+        static to_type to_v8(const from_type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+
+    template <typename T>
+    struct convert<typed_array_view<T>>
+    {
+        using from_type = typed_array_view<T>;
+        using to_type = v8::Local<v8::Value>;
+
+        static from_type from_v8(v8::Local<v8::Value> val)
+        {
+            return from_type::from_local(local(val));
+        }
+
+        // the view doesn't own its memory
+        static to_type to_v8(const from_type&) = delete;
+    };
+#elif defined(JSBIND_JSC)
+    template <typename T>
+    struct convert<typed_array<T>>
+    {
+        using type = typed_array<T>;
+
+        static type from_jsc(JSValueRef) = delete;
+
+        static JSValueRef to_jsc(const type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+
+    template <typename T>
+    struct convert<typed_array_view<T>>
+    {
+        using type = typed_array_view<T>;
+
+        static type from_jsc(JSValueRef val)
+        {
+            return type::from_local(local(val));
+        }
+
+        // the view doesn't own its memory
+        static JSValueRef to_jsc(const type&) = delete;
+    };
+#elif defined(JSBIND_CEF)
+    template <typename T>
+    struct convert<typed_array<T>>
+    {
+        using type = typed_array<T>;
+
+        static type from_cef(CefRefPtr<CefV8Value>) = delete;
+
+        static CefRefPtr<CefV8Value> to_cef(const type& val)
+        {
+            return val.to_local().m_handle;
+        }
+    };
+
+    template <typename T>
+    struct convert<typed_array_view<T>>
+    {
+        using type = typed_array_view<T>;
+
+        static type from_cef(CefRefPtr<CefV8Value> val)
+        {
+            return type::from_local(local(val));
+        }
+
+        // the view doesn't own its memory
+        static CefRefPtr<CefV8Value> to_cef(const type&) = delete;
+    };
+#endif
+}
 }
+
+#if defined(JSBIND_EMSCRIPTEN)
+namespace emscripten
+{
+namespace internal
+{
+    // the emscripten heap can't be adopted by js, so the data is copied out of it
+    template <typename T>
+    struct TypeID<jsbind::typed_array<T>>
+    {
+        static constexpr TYPEID get() { return TypeID<val>::get(); }
+    };
+
+    template <typename T>
+    struct BindingType<jsbind::typed_array<T>>
+    {
+        typedef EM_VAL WireType;
+
+        static WireType toWireType(const jsbind::typed_array<T>& ar)
+        {
+            auto copy = val(typed_memory_view(ar.size(), ar.data())).call<val>("slice");
+            return BindingType<val>::toWireType(copy);
+        }
+    };
+}
+}
+#endif
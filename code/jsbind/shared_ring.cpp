@@ -0,0 +1,195 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "shared_ring.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include "jsbind/post.hpp"
+#include "jsbind/common/deinitializers.hpp"
+
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace jsbind
+{
+
+namespace
+{
+// the header holds uint32 indices, with the ones written by different threads in different cache lines
+// records are a little endian uint32 size followed by the bytes, padded to 4
+// a size of pad_marker means that the rest of the area is skipped
+const uint32_t header_size = 128;
+const uint32_t head_slot = 0;
+const uint32_t notify_slot = 2;
+const uint32_t tail_slot = 16;
+const uint32_t pad_marker = 0xffffffff;
+
+const char* const ring_class_src = R"js(
+(function () {
+    var HEAD = 0, NOTIFY = 2, TAIL = 16, HEADER = 128, PAD = 0xffffffff;
+    function SharedRing(buffer) {
+        this.buffer = buffer;
+        this.index = new Uint32Array(buffer, 0, HEADER / 4);
+        this.capacity = buffer.byteLength - HEADER;
+        this.bytes = new Uint8Array(buffer, HEADER);
+        this.view = new DataView(buffer, HEADER);
+        this.onready = null;
+    }
+    SharedRing.wrap = function (buffer) { return new SharedRing(buffer); };
+    SharedRing.prototype.empty = function () {
+        return Atomics.load(this.index, HEAD) === Atomics.load(this.index, TAIL);
+    };
+    // calls fn for (at most max of) the records which are in the ring now
+    SharedRing.prototype.drain = function (fn, max) {
+        var index = this.index, mask = this.capacity - 1, n = 0;
+        var tail = Atomics.load(index, TAIL), head = Atomics.load(index, HEAD);
+        while (tail !== head && n !== max) {
+            var pos = tail & mask, size = this.view.getUint32(pos, true);
+            if (size === PAD) {
+                tail = (tail + this.capacity - pos) >>> 0;
+            } else {
+                fn(this.bytes.subarray(pos + 4, pos + 4 + size));
+                tail = (tail + ((size + 7) & ~3)) >>> 0;
+                ++n;
+            }
+            Atomics.store(index, TAIL, tail);
+        }
+        return n;
+    };
+    SharedRing.prototype.pop = function () {
+        var ret = null;
+        this.drain(function (bytes) { ret = bytes.slice(); }, 1);
+        return ret;
+    };
+    SharedRing.prototype.arm = function () {
+        Atomics.store(this.index, NOTIFY, 1);
+        // a record pushed before the store may have missed the flag
+        // if the producer took the flag anyway, onready is coming
+        return this.empty() || Atomics.exchange(this.index, NOTIFY, 0) === 0;
+    };
+    return SharedRing;
+})()
+)js";
+
+persistent ring_class;
+
+void clear_ring_class()
+{
+    ring_class.reset();
+}
+
+void write_u32(uint8_t* dst, uint32_t value)
+{
+    memcpy(dst, &value, sizeof(value));
+}
+
+void notify_js(const std::weak_ptr<persistent>& weak_obj)
+{
+    auto obj_ref = weak_obj.lock();
+    if (!obj_ref) return; // the ring is gone
+
+    auto obj = obj_ref->to_local();
+    if (obj["onready"].typeOf().as<std::string>() == "function")
+    {
+        obj.call<void>("onready");
+    }
+}
+}
+
+shared_ring::shared_ring(uint32_t capacity)
+    : m_capacity(capacity)
+    , m_store(internal::backing_store::allocate(header_size + capacity))
+    , m_dropped(0)
+{
+    assert(capacity >= 16 && !(capacity & (capacity - 1)) && "shared_ring: the capacity must be a power of two");
+
+    auto data = m_store->data();
+    memset(data, 0, header_size);
+    m_head = new (data + head_slot * 4) std::atomic<uint32_t>(0);
+    m_notify = new (data + notify_slot * 4) std::atomic<uint32_t>(0);
+    m_tail = new (data + tail_slot * 4) std::atomic<uint32_t>(0);
+    m_records = data + header_size;
+
+    auto buf = internal::make_external_shared_array_buffer(data, m_store->size(), new internal::backing_store_ref(m_store));
+    m_js_object = std::make_shared<persistent>(js_class().call<local>("wrap", buf));
+}
+
+shared_ring::~shared_ring()
+{
+    m_js_object.reset();
+    m_store->release();
+}
+
+bool shared_ring::try_push(const void* data, uint32_t size)
+{
+    if (size > m_capacity - 4)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint32_t record_size = (size + 7) & ~uint32_t(3);
+    auto head = m_head->load(std::memory_order_relaxed);
+    auto tail = m_tail->load(std::memory_order_acquire);
+
+    // records are contiguous, so one which doesn't fit before the end starts over at the beginning
+    auto pos = head & (m_capacity - 1);
+    uint32_t pad = pos + record_size > m_capacity ? m_capacity - pos : 0;
+
+    if (head - tail + pad + record_size > m_capacity)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (pad)
+    {
+        write_u32(m_records + pos, pad_marker);
+        pos = 0;
+    }
+
+    write_u32(m_records + pos, size);
+    if (size)
+    {
+        memcpy(m_records + pos + 4, data, size);
+    }
+
+    // sequentially consistent with the flag, so that either js sees the record when it arms the ring,
+    // or we see the flag here
+    m_head->store(head + pad + record_size, std::memory_order_seq_cst);
+
+    if (m_notify->load(std::memory_order_seq_cst) && m_notify->exchange(0, std::memory_order_seq_cst))
+    {
+        std::weak_ptr<persistent> weak_obj = m_js_object;
+        post([weak_obj]() { notify_js(weak_obj); });
+    }
+
+    return true;
+}
+
+local shared_ring::to_local() const
+{
+    return m_js_object->to_local();
+}
+
+local shared_ring::js_class()
+{
+    if (ring_class.is_empty())
+    {
+        ring_class.reset(local::global("eval")(ring_class_src));
+        internal::add_deinitializer(clear_ring_class);
+    }
+
+    return ring_class.to_local();
+}
+
+}
+
+#endif
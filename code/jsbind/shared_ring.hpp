@@ -0,0 +1,86 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "shared_memory_extension.hpp"
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+namespace jsbind
+{
+
+/// Single producer, single consumer ring of byte records from a C++ thread to js.
+///
+/// The records are in a SharedArrayBuffer (an ArrayBuffer on engines with no shared ones)
+/// which also holds the read and write indices, so the producer pushes without entering
+/// the isolate and js drains the records without calling into C++:
+///
+///     var ring = module.getEvents();
+///     ring.drain(function (bytes) { ... }); // bytes is a Uint8Array, valid only during the call
+///     ring.pop();                           // a copy of the next record or null
+///
+/// Instead of polling, js can set `ring.onready` and arm the ring. The first push after
+/// that posts a call to `onready` (see `post`), which has to arm the ring again.
+/// `arm` returns false if records arrived in the meantime:
+///
+///     ring.onready = function () { do { ring.drain(handle); } while (!ring.arm()); };
+///     ring.onready();
+///
+/// Create and destroy the ring on the js thread, and destroy it only after the producer has
+/// stopped. Only one thread at a time may push.
+class shared_ring
+{
+public:
+    /// `capacity` is the size of the record area in bytes, a power of two.
+    /// A record takes 4 bytes more than its size, rounded up to a multiple of 4.
+    explicit shared_ring(uint32_t capacity);
+    ~shared_ring();
+
+    shared_ring(const shared_ring&) = delete;
+    shared_ring& operator=(const shared_ring&) = delete;
+
+    /// Copies a record into the ring.
+    /// Returns false (and counts a drop) if the ring is full or the record could never fit.
+    bool try_push(const void* data, uint32_t size);
+
+    uint32_t capacity() const { return m_capacity; }
+
+    /// bytes of records which js hasn't consumed yet
+    uint32_t used() const
+    {
+        return m_head->load(std::memory_order_acquire) - m_tail->load(std::memory_order_acquire);
+    }
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    /// the js object of the ring
+    local to_local() const;
+
+    /// the class of the js objects
+    static local js_class();
+
+private:
+    std::atomic<uint32_t>* m_head; // written by the producer
+    std::atomic<uint32_t>* m_tail; // written by js
+    std::atomic<uint32_t>* m_notify; // set by js when it wants onready to be called
+    uint8_t* m_records;
+    uint32_t m_capacity;
+
+    internal::backing_store* m_store;
+    std::shared_ptr<persistent> m_js_object; // weakly referenced by posted notifications
+    std::atomic<uint64_t> m_dropped;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#include "bind.hpp"
+#include "shared_memory_extension.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+namespace jsbind
+{
+
+/// Typed array views of the fields of C++ structs living in an array.
+///
+/// The struct must be registered with `value_object<T>`. Each registered field
+/// which a typed array can hold becomes a view over the live memory of all
+/// structs. For a field `x` the js object looks like this:
+///
+///     { length: <number of structs>, x: { array: Float32Array, offset: 1, stride: 4 } }
+///
+/// and the field of the i-th struct is `view.x.array[view.x.offset + i * view.x.stride]`.
+/// Fields which can't be viewed (strings for example) are skipped.
+///
+/// JS reads and writes the C++ memory directly, so the memory must outlive this
+/// object. If the memory moves (a vector reallocates), call `reset`. The array buffer
+/// behind the views is detached on `reset` and destruction, so on backends which
+/// can detach buffers stale views can't reach freed memory.
+template <typename T>
+class struct_array
+{
+public:
+    struct_array(T* data, size_t size)
+    {
+        reset(data, size);
+    }
+
+    explicit struct_array(std::vector<T>& vec)
+        : struct_array(vec.data(), vec.size())
+    {}
+
+    struct_array(const struct_array&) = delete;
+    struct_array& operator=(const struct_array&) = delete;
+
+    ~struct_array()
+    {
+        m_buffer->detach();
+    }
+
+    void reset(T* data, size_t size)
+    {
+        assert(value_object<T>::is_bound && "struct_array of an unbound value_object");
+
+        if (m_buffer)
+        {
+            m_buffer->detach();
+        }
+
+        m_size = size;
+        m_buffer.reset(new array_buffer(reinterpret_cast<uint8_t*>(data), size * sizeof(T)));
+
+        auto buf = m_buffer->get_persistent().to_local();
+        auto obj = local::object();
+        obj.set("length", uint32_t(size));
+
+        for (auto& field : value_object<T>::fields)
+        {
+            auto& layout = field.layout;
+            if (layout.type == internal::typed_array_type::none) continue;
+
+            auto element_size = internal::typed_array_element_size(layout.type);
+            assert(layout.offset % element_size == 0 && sizeof(T) % element_size == 0
+                && "struct_array: misaligned field");
+
+            auto view = local::object();
+            view.set("array", internal::make_typed_array_view(layout.type, buf));
+            view.set("offset", uint32_t(layout.offset / element_size));
+            view.set("stride", uint32_t(sizeof(T) / element_size));
+            obj.set(layout.name, view);
+        }
+
+        m_persistent.reset(obj);
+    }
+
+    void reset(std::vector<T>& vec)
+    {
+        reset(vec.data(), vec.size());
+    }
+
+    size_t size() const { return m_size; }
+
+    const persistent& get_persistent() const { return m_persistent; }
+
+private:
+    size_t m_size = 0;
+    std::unique_ptr<array_buffer> m_buffer;
+    persistent m_persistent;
+};
+
+}
+
+#endif
@@ -12,6 +12,7 @@
 
 #include "jsbind/common/ptr_cast.hpp"
 #include "jsbind/common/deinitializers.hpp"
+#include "jsbind/common/field_layout.hpp"
 
 namespace jsbind
 {
@@ -31,9 +32,7 @@ namespace internal
 template <typename ReturnType, typename... Args>
 void function(const char* js_name, ReturnType(*func)(Args...))
 {
-    auto ft = v8::FunctionTemplate::New(internal::isolate,
-        internal::call_class_function_from_v8<ReturnType, Args...>,
-        v8::External::New(internal::isolate, reinterpret_cast<void*>(func)));
+    auto ft = internal::make_function_template(func, nullptr, js_name);
 
     auto& g = *internal::class_data::global;
     g->Set(internal::isolate, js_name, ft);
@@ -44,8 +43,10 @@ class class_ : private internal::class_data
 {
 public:
     class_(const char* js_name)
+        : m_name(js_name)
     {
         m_v8func = v8::FunctionTemplate::New(internal::isolate);
+        m_v8func->SetClassName(internal::to_v8(js_name));
         auto& g = *global;
         g->Set(internal::isolate, js_name, m_v8func);
     }
@@ -53,15 +54,13 @@ public:
     template <typename ReturnType, typename... Args>
     class_& class_function(const char* js_name, ReturnType (*class_func)(Args...))
     {
-        auto ft = v8::FunctionTemplate::New(internal::isolate,
-            internal::call_class_function_from_v8<ReturnType, Args...>,
-            v8::External::New(internal::isolate, reinterpret_cast<void*>(class_func)));
+        auto ft = internal::make_function_template(class_func, m_name, js_name);
         m_v8func->Set(internal::isolate, js_name, ft);
         return *this;
     }
 
 private:
-
+    const char* m_name;
 };
 
 namespace internal
@@ -73,6 +72,7 @@ namespace internal
         void* pfield;
         void(*from_v8)(v8::Local<v8::Value> value, void* obj, void* pfield);
         v8::Local<v8::Value>(*to_v8)(const void* obj, void* pfield);
+        field_layout layout;
     };
 }
 
@@ -113,7 +113,8 @@ public:
             internal::value_object_field::name_type(internal::isolate, internal::to_v8(js_name)),
             internal::ptr_cast<Field>(field),
             field_from_v8<Field>,
-            field_to_v8<Field>
+            field_to_v8<Field>,
+            internal::make_field_layout<T>(js_name, field)
         };
         fields.emplace_back(std::move(f));
         return *this;
@@ -11,6 +11,8 @@
 #include "jsbind/error.hpp"
 #include "jsbind/common/index_sequence.hpp"
 #include "jsbind/common/function_traits.hpp"
+#include "jsbind/binding_stats.hpp"
+#include "jsbind/watchdog.hpp"
 #include "convert.hpp"
 
 #include <tuple>
@@ -29,6 +31,7 @@ namespace internal
         // +1 so when there are zero args we at least have something
         v8::Local<v8::Value> v8_args[num_args + 1] = { internal::to_v8(args)... };
 
+        watchdog_scope watch(false);
         v8::TryCatch tc(internal::isolate);
 
         auto& v8ctx = *reinterpret_cast<v8::Local<v8::Context>*>(&internal::ctx.v8ctx);
@@ -59,14 +62,96 @@ namespace internal
         func(from_v8<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ...);
     }
 
+#if defined(JSBIND_BINDING_STATS)
+    // same as tuple_call, but the arguments are converted ahead, so that each part of the call can be timed
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<!is_void_return<Func>::value,
+        void>::type timed_tuple_call(uint32_t stats_id, Func func, const v8::FunctionCallbackInfo<v8::Value>& args, index_sequence<Seq...>)
+    {
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::from_type...> converted{
+            from_v8<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
+
+        auto&& result = func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
+
+        args.GetReturnValue().Set(to_v8(result));
+    }
+
+    template <typename Tuple, typename Func, size_t... Seq>
+    typename std::enable_if<is_void_return<Func>::value,
+        void>::type timed_tuple_call(uint32_t stats_id, Func func, const v8::FunctionCallbackInfo<v8::Value>& args, index_sequence<Seq...>)
+    {
+        binding_timer timer(stats_id);
+        std::tuple<typename convert<typename std::tuple_element<Seq, Tuple>::type>::from_type...> converted{
+            from_v8<typename std::tuple_element<Seq, Tuple>::type>(args[Seq]) ... };
+        timer.args_converted();
+
+        func(forward_converted<typename std::tuple_element<Seq, Tuple>::type>(std::get<Seq>(converted)) ...);
+        timer.body_done();
+    }
+#endif
+
+    // data of the v8 function calling a c++ function
+    inline void* make_function_data(void* func, const char* class_name, const char* name)
+    {
+#if defined(JSBIND_BINDING_STATS)
+        return new_instrumented_function(func, binding_name(class_name, name));
+#else
+        (void)class_name;
+        (void)name;
+        return func;
+#endif
+    }
+
     template <typename ReturnType, typename... Args>
-    void call_class_function_from_v8(const v8::FunctionCallbackInfo<v8::Value>& args)
+    void invoke_function(void* data, const v8::FunctionCallbackInfo<v8::Value>& args)
     {
-        void* data = args.Data().As<v8::External>()->Value();
-        auto func = reinterpret_cast<ReturnType (*)(Args...)>(data);
         JSBIND_JS_CHECK((unsigned long)args.Length() >= sizeof...(Args), "Not enough arguments for function.");
 
+#if defined(JSBIND_BINDING_STATS)
+        auto instrumented = reinterpret_cast<instrumented_function*>(data);
+        auto func = reinterpret_cast<ReturnType (*)(Args...)>(instrumented->func);
+        timed_tuple_call<std::tuple<Args...>>(instrumented->stats_id, func, args, make_index_sequence<sizeof...(Args)>());
+#else
+        auto func = reinterpret_cast<ReturnType (*)(Args...)>(data);
         tuple_call<std::tuple<Args...>>(func, args, make_index_sequence<sizeof...(Args)>());
+#endif
+    }
+
+    template <typename ReturnType, typename... Args>
+    void call_class_function_from_v8(const v8::FunctionCallbackInfo<v8::Value>& args)
+    {
+        invoke_function<ReturnType, Args...>(args.Data().As<v8::External>()->Value(), args);
+    }
+
+    // the profiler names native code by its address, so functions sharing a callback would share a name
+    // each function gets a trampoline of its own which calls the slot of the same index
+    struct function_slot
+    {
+        void(*invoke)(void* data, const v8::FunctionCallbackInfo<v8::Value>& args);
+        void* data;
+    };
+
+    // returns null when all trampolines are taken
+    extern v8::FunctionCallback register_function(const function_slot& slot);
+
+    template <typename ReturnType, typename... Args>
+    v8::Local<v8::FunctionTemplate> make_function_template(ReturnType(*func)(Args...), const char* class_name, const char* name)
+    {
+        function_slot slot = {
+            invoke_function<ReturnType, Args...>,
+            make_function_data(reinterpret_cast<void*>(func), class_name, name)
+        };
+
+        if (auto trampoline = register_function(slot))
+        {
+            return v8::FunctionTemplate::New(isolate, trampoline);
+        }
+
+        return v8::FunctionTemplate::New(isolate, call_class_function_from_v8<ReturnType, Args...>,
+            v8::External::New(isolate, slot.data));
     }
 }
 }
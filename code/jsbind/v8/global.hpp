@@ -14,8 +14,6 @@
 
 #include <v8.h>
 
-#include <new>
-
 namespace jsbind
 {
 
@@ -27,34 +25,10 @@ namespace internal
 
     struct context
     {
-        v8::Locker* m_locker = nullptr;
-
-        void enter()
-        {
-            if (!m_locker) // simple reentry
-            {
-                m_locker = new (buf)v8::Locker(isolate);
-
-                isolate->Enter();
-
-                auto ctx = to_local();
-                ctx->Enter();
-            }
-        }
-
-        void exit()
-        {
-            if (m_locker)
-            {
-                auto ctx = to_local();
-                ctx->Exit();
-
-                isolate->Exit();
-
-                m_locker->~Locker();
-                m_locker = nullptr;
-            }
-        }
+        // enter and exit lock the isolate for the calling thread
+        // they nest per thread, so only the outermost pair locks and unlocks it
+        void enter();
+        void exit();
 
         const v8::Local<v8::Context>& to_local() const
         {
@@ -62,13 +36,17 @@ namespace internal
         }
 
         v8::Persistent<v8::Context> v8ctx;
-
-        char buf[sizeof(v8::Locker)]; // placing the locker here to avoid needless allocations
     };
 
     extern context ctx;
 
     extern void report_exception(const v8::TryCatch& try_catch);
+
+    // an isolate which isn't our own (node's) is left as it is, unless the depth was set explicitly
+    extern void init_exception_stack_depth(bool own_isolate);
+
+    // adds or removes the near heap limit callback after the handler or the limits change
+    extern void update_near_heap_limit_callback();
 }
 
 }
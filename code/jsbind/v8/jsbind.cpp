@@ -11,6 +11,11 @@
 #include "global.hpp"
 #include "jsbind/console.hpp"
 #include "jsbind/exception.hpp"
+#include "jsbind/watchdog.hpp"
+#include "jsbind/post.hpp"
+#include "jsbind/gc.hpp"
+#include "jsbind/context_lock.hpp"
+#include "jsbind/common/ticket_lock.hpp"
 #include "jsbind/common/deinitializers.hpp"
 
 #if defined(JSBIND_NODE)
@@ -28,6 +33,10 @@
 
 #include <sstream>
 #include <iostream>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <algorithm>
 
 using namespace v8;
 using namespace jsbind::internal;
@@ -100,16 +109,29 @@ struct V8Initializer
 void v8_msg(jsbind::console::msg_type type, int startArg, const v8::FunctionCallbackInfo<v8::Value>& args)
 {
     auto con = jsbind::get_console();
-    if (!con) return;
+    if (!con || !con->is_enabled(type)) return;
 
-    std::ostringstream sout;
+    // reused, so that formatting doesn't allocate once the buffer is big enough
+    static thread_local std::string buf;
+    buf.clear();
+
+    // values which can't be converted (like symbols) are skipped without an exception
+    v8::TryCatch try_catch(isolate);
+    auto context = isolate->GetCurrentContext();
     for (int i = startArg; i < args.Length(); ++i)
     {
-        if (i != startArg) sout << ' ';
-        sout << from_v8<std::string>(args[i]);
+        if (i != startArg) buf += ' ';
+
+        v8::Local<v8::String> str;
+        if (!args[i]->ToString(context).ToLocal(&str)) continue;
+
+        auto begin = buf.size();
+        auto length = str->Utf8Length(isolate);
+        buf.resize(begin + size_t(length));
+        str->WriteUtf8(isolate, &buf[begin], length, nullptr, v8::String::NO_NULL_TERMINATION);
     }
 
-    con->msg(type, sout.str().c_str());
+    con->msg(type, buf.c_str());
 }
 
 void v8_log(const v8::FunctionCallbackInfo<v8::Value>& args)
@@ -162,64 +184,280 @@ namespace internal
     context ctx;
     extern void initialize_bindings();
 
+    namespace
+    {
+    using lock_clock = std::chrono::steady_clock;
+
+    uint64_t ns_since(lock_clock::time_point start)
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(lock_clock::now() - start).count());
+    }
+
+    // the locker of each thread is placed in its own storage to avoid needless allocations
+    thread_local int t_context_depth = 0;
+    thread_local v8::Locker* t_locker = nullptr;
+    thread_local bool t_ticket = false;
+    thread_local lock_clock::time_point t_acquired;
+    alignas(v8::Locker) thread_local char t_locker_buf[sizeof(v8::Locker)];
+
+    std::atomic<bool> context_held(false);
+    std::atomic<bool> fair_context_lock(false);
+    ticket_lock context_ticket;
+
+    histogram lock_wait_ns;
+    histogram lock_hold_ns;
+    std::atomic<uint64_t> lock_acquisitions(0);
+    std::atomic<uint64_t> lock_contended(0);
+
+    // the number of functions with a trampoline of their own
+    // functions registered after the trampolines run out share the callback of their signature
+    const size_t num_function_slots = 1024;
+    const size_t function_block = 64;
+
+    function_slot function_slots[num_function_slots];
+    v8::FunctionCallback function_trampolines[num_function_slots];
+    size_t num_used_function_slots = 0;
+
+    template <size_t I>
+    void call_function_slot(const v8::FunctionCallbackInfo<v8::Value>& args)
+    {
+        auto& slot = function_slots[I];
+        slot.invoke(slot.data, args);
+    }
+
+    template <size_t Base, size_t... I>
+    void fill_trampoline_block(index_sequence<I...>)
+    {
+        v8::FunctionCallback block[] = { call_function_slot<Base + I>... };
+        for (size_t i = 0; i < sizeof...(I); ++i)
+        {
+            function_trampolines[Base + i] = block[i];
+        }
+    }
+
+    // in blocks, to keep the recursion of make_index_sequence shallow
+    template <size_t... B>
+    void fill_trampolines(index_sequence<B...>)
+    {
+        int expand[] = { (fill_trampoline_block<B * function_block>(make_index_sequence<function_block>()), 0)... };
+        (void)expand;
+    }
+
+    // the slots are taken again by the bindings of the next initialization
+    void release_function_slots()
+    {
+        num_used_function_slots = 0;
+    }
+    }
+
+    v8::FunctionCallback register_function(const function_slot& slot)
+    {
+        if (num_used_function_slots == num_function_slots) return nullptr;
+
+        if (!function_trampolines[0])
+        {
+            fill_trampolines(make_index_sequence<num_function_slots / function_block>());
+        }
+
+        if (num_used_function_slots == 0)
+        {
+            add_deinitializer(release_function_slots);
+        }
+
+        auto i = num_used_function_slots++;
+        function_slots[i] = slot;
+        return function_trampolines[i];
+    }
+
+    void context::enter()
+    {
+        if (t_context_depth++)
+        {
+            // the thread already holds the isolate
+            return;
+        }
+
+        auto start = lock_clock::now();
+
+        // the depth of this thread was zero, so a holder is some other thread
+        bool contended = context_held.load(std::memory_order_relaxed);
+
+        // the ticket only orders the threads, the locker still does the locking
+        t_ticket = fair_context_lock.load(std::memory_order_relaxed);
+        if (t_ticket)
+        {
+            context_ticket.lock();
+        }
+
+        t_locker = new (t_locker_buf)v8::Locker(isolate);
+        context_held.store(true, std::memory_order_relaxed);
+
+        lock_wait_ns.record(ns_since(start));
+        lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (contended)
+        {
+            lock_contended.fetch_add(1, std::memory_order_relaxed);
+        }
+        t_acquired = lock_clock::now();
+
+        isolate->Enter();
+        to_local()->Enter();
+    }
+
+    void context::exit()
+    {
+        if (!t_context_depth || --t_context_depth)
+        {
+            // not entered (ignored as before) or still nested
+            return;
+        }
+
+        to_local()->Exit();
+        isolate->Exit();
+
+        lock_hold_ns.record(ns_since(t_acquired));
+        context_held.store(false, std::memory_order_relaxed);
+
+        t_locker->~Locker();
+        t_locker = nullptr;
+
+        if (t_ticket)
+        {
+            context_ticket.unlock();
+            t_ticket = false;
+        }
+    }
+
     v8::Local<v8::ObjectTemplate>* class_data::global = nullptr;
 
-    void report_exception(const v8::TryCatch& tryCatch)
+    namespace
     {
-        auto eh = get_exception_handler();
-        if (!eh) return;
+    std::string to_std_string(v8::Local<v8::Value> val)
+    {
+        if (val.IsEmpty()) return std::string();
+        v8::String::Utf8Value str(isolate, val);
+        return *str ? std::string(*str, str.length()) : std::string();
+    }
 
-        v8::HandleScope handleScope(isolate);
+    // reads the parts of the exception from the try catch when they're asked for
+    class v8_exception_info : public exception_info
+    {
+    public:
+        explicit v8_exception_info(const v8::TryCatch& try_catch)
+            : m_try_catch(try_catch)
+            , m_message(try_catch.Message())
+        {}
 
-        v8::String::Utf8Value exception(isolate, tryCatch.Exception());
-        const char* exceptionString = *exception;
-        v8::Handle<v8::Message> message = tryCatch.Message();
+        virtual std::string message() const override
+        {
+            return to_std_string(m_try_catch.Exception());
+        }
 
-        stringstream ss;
+        virtual std::string resource() const override
+        {
+            return m_message.IsEmpty() ? std::string() : to_std_string(m_message->GetScriptResourceName());
+        }
+
+        virtual int line() const override
+        {
+            return m_message.IsEmpty() ? 0 : m_message->GetLineNumber(ctx.to_local()).FromMaybe(0);
+        }
+
+        virtual int start_column() const override
+        {
+            return m_message.IsEmpty() ? 0 : m_message->GetStartColumn();
+        }
+
+        virtual int end_column() const override
+        {
+            return m_message.IsEmpty() ? 0 : m_message->GetEndColumn();
+        }
 
-        if (message.IsEmpty())
+        virtual std::string source_line() const override
         {
-            // V8 didn't provide any extra information about this error; just
-            // print the exception.
-            ss << exceptionString;
+            if (m_message.IsEmpty()) return std::string();
+            return to_std_string(m_message->GetSourceLine(ctx.to_local()).FromMaybe(v8::Local<v8::String>()));
+        }
+
+        virtual std::vector<stack_frame> frames() const override
+        {
+            std::vector<stack_frame> ret;
+            if (m_message.IsEmpty()) return ret;
+
+            // only captured if enabled with set_exception_stack_depth
+            auto trace = m_message->GetStackTrace();
+            if (trace.IsEmpty()) return ret;
+
+            int count = trace->GetFrameCount();
+            ret.reserve(size_t(count));
+            for (int i = 0; i < count; ++i)
+            {
+                auto frame = trace->GetFrame(isolate, uint32_t(i));
+                ret.push_back({
+                    to_std_string(frame->GetFunctionName()),
+                    to_std_string(frame->GetScriptName()),
+                    frame->GetLineNumber(),
+                    frame->GetColumn(),
+                });
+            }
+            return ret;
         }
-        else
+
+        virtual std::string text() const override
         {
+            auto exception = message();
+
+            if (m_message.IsEmpty())
+            {
+                // V8 didn't provide any extra information about this error; just
+                // print the exception.
+                return exception;
+            }
+
+            stringstream ss;
+
             // Print (filename):(line number): (message).
-            auto& v8ctx = *reinterpret_cast<v8::Local<v8::Context>*>(&ctx.v8ctx);
-            v8::String::Utf8Value filename(isolate, message->GetScriptResourceName());
-            const char* filenameString = *filename;
-            int linenum = message->GetLineNumber(v8ctx).FromMaybe(0);
-            ss << filenameString << ":" << linenum << ": " << exceptionString << std::endl;
+            ss << resource() << ":" << line() << ": " << exception << std::endl;
 
-            v8::Local<v8::Value> emptyString;
             // Print line of source code.
-            v8::String::Utf8Value sourceline(isolate, message->GetSourceLine(v8ctx).FromMaybe(emptyString));
-            const char* sourceline_string = *sourceline;
-            ss << sourceline_string << std::endl;
+            ss << source_line() << std::endl;
 
             // Print wavy underline (GetUnderline is deprecated).
-            int start = message->GetStartColumn();
-
+            int start = start_column();
             for (int i = 0; i < start; i++)
             {
                 ss << " ";
             }
-            int end = message->GetEndColumn();
+            int end = end_column();
             for (int i = start; i < end; i++)
             {
                 ss << "^";
             }
             ss << std::endl;
 
-            v8::String::Utf8Value stack_trace(isolate, tryCatch.StackTrace(v8ctx).FromMaybe(emptyString));
-            if (stack_trace.length() > 0) {
-                const char* stack_trace_string = *stack_trace;
-                ss << stack_trace_string;
-            }
+            ss << to_std_string(m_try_catch.StackTrace(ctx.to_local()).FromMaybe(v8::Local<v8::Value>()));
+
+            return ss.str();
         }
 
-        eh->on_exception(ss.str().c_str());
+    private:
+        const v8::TryCatch& m_try_catch;
+        v8::Local<v8::Message> m_message;
+    };
+    }
+
+    void report_exception(const v8::TryCatch& tryCatch)
+    {
+        auto eh = get_exception_handler();
+        if (!eh) return;
+
+        // terminations are reported by whatever terminated the execution (the watchdog or the heap limit)
+        if (tryCatch.HasTerminated()) return;
+
+        v8::HandleScope handleScope(isolate);
+
+        v8_exception_info info(tryCatch);
+        eh->on_exception_info(info);
     }
 
     void report_fatal_error(const char* location, const char* message)
@@ -231,6 +469,129 @@ namespace internal
         ss << location << ": " << message;
         eh->on_engine_error(ss.str().c_str());
     }
+
+    // gc instrumentation
+    struct gc_start
+    {
+        chrono::steady_clock::time_point time;
+        size_t used_heap_size;
+    };
+    gc_start gc_starts[gc_num_types];
+
+    gc_type to_gc_type(GCType type)
+    {
+        switch (type)
+        {
+        case kGCTypeScavenge: return gc_scavenge;
+        case kGCTypeMarkSweepCompact: return gc_mark_compact;
+        case kGCTypeIncrementalMarking: return gc_incremental_marking;
+        case kGCTypeProcessWeakCallbacks: return gc_weak_callbacks;
+        default: return gc_other;
+        }
+    }
+
+    size_t get_used_heap_size(Isolate* i)
+    {
+        HeapStatistics hs;
+        i->GetHeapStatistics(&hs);
+        return hs.used_heap_size();
+    }
+
+    void gc_prologue(Isolate* i, GCType type, GCCallbackFlags)
+    {
+        auto& start = gc_starts[to_gc_type(type)];
+        start.used_heap_size = get_used_heap_size(i);
+        start.time = chrono::steady_clock::now();
+    }
+
+    void gc_epilogue(Isolate* i, GCType type, GCCallbackFlags)
+    {
+        auto end = chrono::steady_clock::now();
+
+        gc_event e;
+        e.type = to_gc_type(type);
+        auto& start = gc_starts[e.type];
+        e.duration_us = uint64_t(chrono::duration_cast<chrono::microseconds>(end - start.time).count());
+        e.used_heap_size = get_used_heap_size(i);
+        e.bytes_freed = int64_t(start.used_heap_size) - int64_t(e.used_heap_size);
+
+        record_gc(e);
+    }
+
+    size_t near_heap_limit(void*, size_t current_heap_limit, size_t initial_heap_limit)
+    {
+        // the limit is raised at most twice: once for the handler to shed memory and once to unwind the js
+        // so however much the handler sheds, the heap never grows past half again its initial limit
+        const size_t shed_limit = initial_heap_limit + initial_heap_limit / 4;
+        const size_t terminate_limit = initial_heap_limit + initial_heap_limit / 2;
+
+        auto handler = get_heap_limit_handler();
+        auto action = heap_limit_handler::terminate;
+        if (handler && current_heap_limit < shed_limit)
+        {
+            action = handler->on_near_heap_limit(current_heap_limit);
+        }
+
+        if (action == heap_limit_handler::shed)
+        {
+            return shed_limit;
+        }
+
+        isolate->TerminateExecution();
+
+        if (auto eh = get_exception_handler())
+        {
+            eh->on_engine_error("jsbind: js heap limit reached, execution terminated");
+        }
+
+        // v8 restores the initial limit once the heap is back under half of it
+        return std::max(current_heap_limit, terminate_limit);
+    }
+
+    bool near_heap_limit_added = false;
+
+    void add_heap_callbacks()
+    {
+        isolate->AddGCPrologueCallback(gc_prologue);
+        isolate->AddGCEpilogueCallback(gc_epilogue);
+        update_near_heap_limit_callback();
+    }
+
+    void remove_heap_callbacks()
+    {
+        isolate->RemoveGCPrologueCallback(gc_prologue);
+        isolate->RemoveGCEpilogueCallback(gc_epilogue);
+
+        if (near_heap_limit_added)
+        {
+            isolate->RemoveNearHeapLimitCallback(near_heap_limit, 0);
+            near_heap_limit_added = false;
+        }
+    }
+
+    // the callback replaces v8's out of memory failure, so it's only added when asked for
+    // node's own handling of the limit is kept, unless there is a handler
+    void update_near_heap_limit_callback()
+    {
+        if (!isolate) return;
+
+        bool wanted = !!get_heap_limit_handler();
+#if !defined(JSBIND_NODE)
+        auto& limits = get_heap_limits();
+        wanted = wanted || limits.max_young_generation_size || limits.max_old_generation_size;
+#endif
+
+        if (wanted && !near_heap_limit_added)
+        {
+            isolate->AddNearHeapLimitCallback(near_heap_limit, nullptr);
+            isolate->AutomaticallyRestoreInitialHeapLimit();
+        }
+        else if (!wanted && near_heap_limit_added)
+        {
+            isolate->RemoveNearHeapLimitCallback(near_heap_limit, 0);
+        }
+        near_heap_limit_added = wanted;
+    }
 }
 
 #if !defined(JSBIND_NODE)
@@ -240,6 +601,18 @@ void initialize()
 
     Isolate::CreateParams params;
     params.array_buffer_allocator = &initializer.allocator;
+
+    auto& limits = get_heap_limits();
+    if (limits.max_young_generation_size)
+    {
+        // the young generation is three semi-spaces
+        params.constraints.set_max_semi_space_size_in_kb(limits.max_young_generation_size / 3 / 1024);
+    }
+    if (limits.max_old_generation_size)
+    {
+        params.constraints.set_max_old_space_size(limits.max_old_generation_size / (1024 * 1024));
+    }
+
     isolate = Isolate::New(params);
 
     {
@@ -274,6 +647,9 @@ void initialize()
 
         ctx.enter();
         isolate->SetFatalErrorHandler(report_fatal_error);
+        init_exception_stack_depth(true);
+        add_heap_callbacks();
+        initialize_posted_tasks();
         ctx.exit();
     }
 }
@@ -289,6 +665,10 @@ void v8_initialize_with_global(v8::Local<Object> global)
     auto lctx = isolate->GetCurrentContext();
     ctx.v8ctx.Reset(isolate, lctx);
 
+    add_heap_callbacks();
+    init_exception_stack_depth(false);
+    initialize_posted_tasks();
+
     // bindings
     v8::Local<v8::ObjectTemplate> module = v8::ObjectTemplate::New(isolate);
     class_data::global = &module;
@@ -305,6 +685,8 @@ void deinitialize()
 {
     internal::run_deinitializers();
 
+    remove_heap_callbacks();
+
     ctx.v8ctx.Reset();
 #if !defined(JSBIND_NODE)
     // node manages the isolate
@@ -313,6 +695,20 @@ void deinitialize()
     isolate = nullptr;
 }
 
+heap_stats get_heap_stats()
+{
+    HeapStatistics hs;
+    isolate->GetHeapStatistics(&hs);
+
+    heap_stats ret;
+    ret.total_heap_size = hs.total_heap_size();
+    ret.used_heap_size = hs.used_heap_size();
+    ret.heap_size_limit = hs.heap_size_limit();
+    ret.malloced_memory = hs.malloced_memory();
+    ret.external_memory = hs.external_memory();
+    return ret;
+}
+
 void enter_context()
 {
 #if !defined(JSBIND_NODE)
@@ -329,9 +725,25 @@ void exit_context()
 #endif
 }
 
+context_lock_stats get_context_lock_stats(bool roll)
+{
+    context_lock_stats ret;
+    ret.wait_ns = roll ? lock_wait_ns.roll() : lock_wait_ns.get();
+    ret.hold_ns = roll ? lock_hold_ns.roll() : lock_hold_ns.get();
+    ret.acquisitions = lock_acquisitions.load(std::memory_order_relaxed);
+    ret.contended = lock_contended.load(std::memory_order_relaxed);
+    return ret;
+}
+
+void set_fair_context_lock(bool fair)
+{
+    fair_context_lock.store(fair, std::memory_order_relaxed);
+}
+
 void run_script(const char* src, const char* fname)
 {
     HandleScope scope(isolate);
+    watchdog_scope watch(true);
 
     auto& v8ctx = *reinterpret_cast<v8::Local<v8::Context>*>(&internal::ctx.v8ctx);
 
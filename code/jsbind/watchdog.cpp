@@ -0,0 +1,142 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#include "watchdog.hpp"
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include "exception.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(JSBIND_V8)
+#   include "jsbind/v8/global.hpp"
+#endif
+
+namespace jsbind
+{
+
+namespace internal
+{
+    watchdog* current_watchdog = nullptr;
+}
+
+void set_watchdog(watchdog* w)
+{
+    internal::current_watchdog = w;
+}
+
+watchdog* get_watchdog()
+{
+    return internal::current_watchdog;
+}
+
+const int64_t watchdog::disarmed;
+const int64_t watchdog::expired;
+
+watchdog::watchdog(duration script_limit, duration call_limit)
+    : m_script_limit(script_limit)
+    , m_call_limit(call_limit)
+    , m_armed_limit(duration::zero())
+    , m_deadline(disarmed)
+    , m_terminated(false)
+    , m_timeouts(0)
+{
+    duration shortest = duration::max();
+    if (script_limit > duration::zero()) shortest = std::min(shortest, script_limit);
+    if (call_limit > duration::zero()) shortest = std::min(shortest, call_limit);
+
+    m_tick = std::max<duration>(shortest / 10, std::chrono::milliseconds(1));
+    if (shortest == duration::max()) m_tick = std::chrono::seconds(1);
+
+    m_thread = std::thread(&watchdog::run, this);
+}
+
+watchdog::~watchdog()
+{
+    if (internal::current_watchdog == this)
+    {
+        internal::current_watchdog = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+int64_t watchdog::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void watchdog::enter(bool is_script)
+{
+    if (m_depth++) return;
+
+    m_armed_limit = is_script ? m_script_limit : m_call_limit;
+    if (m_armed_limit <= duration::zero()) return;
+
+    m_deadline.store(now_ns() + std::chrono::duration_cast<std::chrono::nanoseconds>(m_armed_limit).count(), std::memory_order_release);
+}
+
+void watchdog::exit()
+{
+    if (--m_depth) return;
+
+    if (m_deadline.exchange(disarmed, std::memory_order_acq_rel) != expired) return;
+
+    // the watchdog thread took the deadline and may still be terminating the execution
+    while (!m_terminated.load(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+    m_terminated.store(false, std::memory_order_relaxed);
+
+#if defined(JSBIND_V8)
+    // the terminated execution has returned, so the isolate can run js again
+    internal::isolate->CancelTerminateExecution();
+#endif
+
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto eh = get_exception_handler())
+    {
+        std::ostringstream sout;
+        sout << "jsbind: js execution timed out after "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(m_armed_limit).count() << " ms";
+        eh->on_engine_error(sout.str().c_str());
+    }
+}
+
+void watchdog::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        m_wake.wait_for(lock, m_tick);
+
+        auto deadline = m_deadline.load(std::memory_order_acquire);
+        if (deadline <= disarmed || now_ns() < deadline) continue;
+
+        // the engine thread may disarm concurrently, so the deadline is taken only if it's still the same
+        if (!m_deadline.compare_exchange_strong(deadline, expired, std::memory_order_acq_rel)) continue;
+
+#if defined(JSBIND_V8)
+        internal::isolate->TerminateExecution();
+#endif
+        m_terminated.store(true, std::memory_order_release);
+    }
+}
+
+}
+
+#endif
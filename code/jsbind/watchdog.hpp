@@ -0,0 +1,115 @@
+// jsbind
+// Copyright (c) 2019 Chobolabs Inc.
+// http://www.chobolabs.com/
+//
+// Distributed under the MIT Software License
+// See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/MIT
+//
+#pragma once
+
+#if !defined(JSBIND_EMSCRIPTEN)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace jsbind
+{
+
+/// Stops js which runs for too long.
+///
+///     static jsbind::watchdog wd(std::chrono::milliseconds(100), std::chrono::milliseconds(10));
+///     jsbind::set_watchdog(&wd);
+///
+/// While it's set, `run_script` and the calls from C++ to js (`local::call`, `local::operator()`)
+/// have a deadline. Only the outermost one is timed, so a call from a bound C++ function back
+/// to js counts against the limit of the script which called it. A background thread checks the
+/// deadline every tick (a tenth of the smaller limit). When it passes on v8, the execution is
+/// terminated with `v8::Isolate::TerminateExecution`, the call returns undefined, the exception
+/// handler receives an engine error and the isolate is usable again.
+///
+/// Other engines can't be interrupted from another thread, so there timeouts are only counted
+/// and reported when the execution finishes.
+class watchdog
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    // a zero limit means no limit
+    watchdog(duration script_limit, duration call_limit);
+    ~watchdog();
+
+    watchdog(const watchdog&) = delete;
+    watchdog& operator=(const watchdog&) = delete;
+
+    /// Number of executions which ran past their deadline.
+    uint64_t timeouts() const { return m_timeouts.load(std::memory_order_relaxed); }
+
+    // called by the engine thread around executions
+    void enter(bool is_script);
+    void exit();
+
+private:
+    void run();
+
+    // nanoseconds since the epoch of the steady clock
+    static int64_t now_ns();
+
+    // values of m_deadline besides actual deadlines
+    static const int64_t disarmed = 0;
+    static const int64_t expired = -1;
+
+    const duration m_script_limit;
+    const duration m_call_limit;
+    duration m_tick;
+
+    int m_depth = 0; // of nested executions, only used by the engine thread
+    duration m_armed_limit;
+
+    std::atomic<int64_t> m_deadline;
+    std::atomic<bool> m_terminated; // set after the execution is terminated
+    std::atomic<uint64_t> m_timeouts;
+
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+};
+
+extern void set_watchdog(watchdog* w);
+extern watchdog* get_watchdog();
+
+namespace internal
+{
+    extern watchdog* current_watchdog;
+
+    // times an execution if a watchdog is set
+    class watchdog_scope
+    {
+    public:
+        explicit watchdog_scope(bool is_script)
+            : m_watchdog(current_watchdog)
+        {
+            if (m_watchdog) m_watchdog->enter(is_script);
+        }
+
+        ~watchdog_scope()
+        {
+            if (m_watchdog) m_watchdog->exit();
+        }
+
+        watchdog_scope(const watchdog_scope&) = delete;
+        watchdog_scope& operator=(const watchdog_scope&) = delete;
+
+    private:
+        watchdog* m_watchdog;
+    };
+}
+
+}
+
+#endif
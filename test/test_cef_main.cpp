@@ -11,6 +11,8 @@
 #include <include/wrapper/cef_message_router.h>
 #include <include/wrapper/cef_resource_manager.h>
 
+#include <jsbind/cef_bridge.hpp>
+
 #include <thread> // so we can sleep in the main loop
 #include <atomic>
 
@@ -25,7 +27,8 @@ const char* HTML = R"demohtml(
 <!DOCTYPE html>
 <html>
 <script>
-    Module.htmlLoaded(); // notify that it's safe to exit
+    // notify that it's safe to exit
+    Module.bridgeCall('sum', [[1, 2, 3]]).then(Module.htmlLoaded, function () { Module.htmlLoaded(0); });
 </script>
 </html>
 )demohtml";
@@ -35,6 +38,13 @@ const char* URL = "https://jsbind/test";
 std::atomic_bool safeToExit;
 int testResult;
 
+int Sum(const std::vector<int>& values)
+{
+    int sum = 0;
+    for (auto v : values) sum += v;
+    return sum;
+}
+
 void SetupResourceManagerOnIOThread(CefRefPtr<CefResourceManager> resourceManager)
 {
     if (!CefCurrentlyOn(TID_IO))
@@ -53,6 +63,7 @@ public:
         : m_resourceManager(new CefResourceManager)
     {
         SetupResourceManagerOnIOThread(m_resourceManager);
+        m_bridge.handler("sum", Sum);
     }
 
     virtual CefRefPtr<CefRequestHandler> GetRequestHandler() override { return this; }
@@ -68,7 +79,7 @@ public:
             safeToExit = true;
             return true;
         }
-        return false;
+        return m_bridge.on_message(browser, message);
     }
 
     /////////////////////////////////////
@@ -109,6 +120,7 @@ public:
 
 private:
     CefRefPtr<CefResourceManager> m_resourceManager;
+    jsbind::bridge_host m_bridge;
 
     IMPLEMENT_REFCOUNTING(HeadlessClient);
     DISALLOW_COPY_AND_ASSIGN(HeadlessClient);
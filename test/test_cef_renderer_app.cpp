@@ -9,17 +9,19 @@
 #include <include/cef_app.h>
 
 #include <jsbind.hpp>
+#include <jsbind/cef_bridge.hpp>
 #include <testlib.hpp>
 
 #define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <doctest/doctest.h>
 
-void onHtmlLoaded();
+void onHtmlLoaded(int bridgeSum);
 
 JSBIND_BINDINGS(Tests)
 {
     jsbind::function("htmlLoaded", onHtmlLoaded);
+    jsbind::function("bridgeCall", jsbind::bridge_call);
 }
 
 namespace
@@ -49,6 +51,11 @@ public:
         jsbind::deinitialize();
     }
 
+    bool OnProcessMessageReceived(CefRefPtr<CefBrowser> /*browser*/, CefProcessId /*source_process*/, CefRefPtr<CefProcessMessage> message) override
+    {
+        return jsbind::on_bridge_reply(message);
+    }
+
 private:
     IMPLEMENT_REFCOUNTING(RendererApp);
     DISALLOW_COPY_AND_ASSIGN(RendererApp);
@@ -56,8 +63,14 @@ private:
 
 }
 
-void onHtmlLoaded()
+// the html sums [1, 2, 3] in the browser process through the bridge
+void onHtmlLoaded(int bridgeSum)
 {
+    if (testResult == 0 && bridgeSum != 6)
+    {
+        testResult = 1;
+    }
+
     auto msg = CefProcessMessage::Create("testing_done");
     msg->GetArgumentList()->SetInt(0, testResult);
     CefV8Context::GetCurrentContext()->GetBrowser()->SendProcessMessage(PID_BROWSER, msg);
@@ -8,6 +8,7 @@
 //
 #include "pods.hpp"
 #include <jsbind.hpp>
+#include <jsbind/shared_memory_extension.hpp>
 
 JSBIND_BINDINGS(pods)
 {
@@ -31,12 +32,15 @@ JSBIND_BINDINGS(pods)
 
     function("getStoredVec", &get_stored_vec);
     function("storeVec", &store_vec);
+    function("storeVecCopy", &store_vec); // the same signature, which has to be told apart in profiles
     function("getStoredMec", &get_stored_mec);
     function("storeMec", &store_mec);
     function("getStoredSec", &get_stored_sec);
     function("storeSec", &store_sec);
     function("getStoredNec", &get_stored_nec);
     function("storeNec", &store_nec);
+
+    function("makeFloats", &make_floats);
 }
 
 namespace
@@ -45,6 +49,36 @@ jsbind::test::vec the_vec;
 jsbind::test::mec the_mec;
 jsbind::test::sec the_sec;
 jsbind::test::nec the_nec;
+
+float* made_floats = nullptr;
+int num_live_float_buffers = 0;
+
+template <typename T>
+struct counting_allocator
+{
+    typedef T value_type;
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        ++num_live_float_buffers;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        --num_live_float_buffers;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const { return false; }
+};
 }
 
 namespace jsbind
@@ -92,5 +126,27 @@ nec get_stored_nec()
     return the_nec;
 }
 
+typed_array<float> make_floats(int n)
+{
+    std::vector<float, counting_allocator<float>> ret;
+    ret.reserve(size_t(n));
+    for (int i = 0; i < n; ++i)
+    {
+        ret.push_back(float(i));
+    }
+    made_floats = ret.data();
+    return typed_array<float>(std::move(ret));
+}
+
+float* get_made_floats()
+{
+    return made_floats;
+}
+
+int get_num_live_float_buffers()
+{
+    return num_live_float_buffers;
+}
+
 }
 }
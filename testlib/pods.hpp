@@ -8,10 +8,16 @@
 //
 #pragma once
 
+#include "jsbind/common/field_layout.hpp"
+
 #include <string>
 
 namespace jsbind
 {
+
+template <typename T>
+class typed_array;
+
 namespace test
 {
 
@@ -49,6 +55,15 @@ struct nec
 void store_nec(const nec& m);
 nec get_stored_nec();
 
+// a float array of 0, 1, ... n-1 which is moved to js without copying
+typed_array<float> make_floats(int n);
+float* get_made_floats(); // the storage of the last one
+int get_num_live_float_buffers(); // freed when js collects them
+
 }
 
+// sent as a packed_array in the tests
+template <>
+struct packed_struct<test::vec> : std::true_type {};
+
 }
@@ -8,8 +8,25 @@
 //
 #include "jsbind.hpp"
 #include "jsbind/console.hpp"
+#include "jsbind/async_console.hpp"
 #include "jsbind/exception.hpp"
+#include "jsbind/exception_throttle.hpp"
+#include "jsbind/watchdog.hpp"
+#include "jsbind/post.hpp"
 #include "jsbind/shared_memory_extension.hpp"
+#include "jsbind/mapped_array_buffer.hpp"
+#include "jsbind/struct_array.hpp"
+#include "jsbind/packed_array.hpp"
+#include "jsbind/serialization.hpp"
+#include "jsbind/shared_ring.hpp"
+#include "jsbind/gc.hpp"
+#include "jsbind/context_lock.hpp"
+#include "jsbind/common/ticket_lock.hpp"
+#include "jsbind/binding_stats.hpp"
+#include "jsbind/profiler.hpp"
+#include "jsbind/heap_snapshot.hpp"
+#include "jsbind/context.hpp"
+#include "jsbind/cef_bridge.hpp"
 
 #include "person.hpp"
 #include "testclass.hpp"
@@ -18,6 +35,14 @@
 #include <iostream>
 #include <cstdint>
 #include <cmath>
+#include <cstdio>
+#include <thread>
+#include <future>
+#include <atomic>
+
+#if defined(JSBIND_NODE)
+#   include <node.h>
+#endif
 
 #define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
 #include "doctest/doctest.h"
@@ -79,6 +104,12 @@ DOCTEST_TEST_CASE("local")
     local str("strvalue");
     DOCTEST_CHECK(str.as<std::string>() == "strvalue");
 
+    // multi-byte characters, a surrogate pair and an embedded null
+    const std::string utf8("h\xc3\xa9llo \xe2\x82\xac \xf0\x9f\x98\x80\0end", 19);
+    local ustr(utf8);
+    DOCTEST_CHECK(ustr["length"].as<int>() == 14);
+    DOCTEST_CHECK(ustr.as<std::string>() == utf8);
+
     local integer(23);
     DOCTEST_CHECK(integer.as<int8_t>() == 23);
     DOCTEST_CHECK(integer.as<int16_t>() == 23);
@@ -516,6 +547,24 @@ DOCTEST_TEST_CASE("console")
     DOCTEST_CHECK(con.m_debug == "foo bar");
     DOCTEST_CHECK(con.m_assert == "baz");
 
+    // disabled messages are not formatted at all
+    class no_debug_console : public myconsole
+    {
+        virtual bool is_enabled(msg_type type) const override { return type != msg_debug; }
+    } filtered;
+    set_console(&filtered);
+    run_script(
+        "var formatted = false;"
+        "console.debug({ toString: function() { formatted = true; return 'x'; } });"
+        "console.log({ toString: function() { return 'logged'; } });"
+        , "console");
+
+    DOCTEST_CHECK(filtered.m_debug.empty());
+    DOCTEST_CHECK(filtered.m_log == "logged");
+    DOCTEST_CHECK(local::global("formatted").isFalse());
+
+    set_default_console();
+
     DOCTEST_CHECK(test_handler->get_num_caught() == 0);
 }
 #endif
@@ -542,6 +591,428 @@ DOCTEST_TEST_CASE("except")
 }
 #endif
 
+#if !defined(JSBIND_EMSCRIPTEN)
+DOCTEST_TEST_CASE("async console")
+{
+    class collecting_console : public console
+    {
+    public:
+        virtual void msg(msg_type type, const char* msg) override
+        {
+            m_msgs.push_back(msg);
+            m_from_caller = m_from_caller || std::this_thread::get_id() == m_caller;
+        }
+
+        std::vector<std::string> m_msgs;
+        std::thread::id m_caller = std::this_thread::get_id();
+        bool m_from_caller = false;
+    } target;
+
+    {
+        async_console con(&target, 128); // room for all messages, so that none are dropped
+
+        // two producers, each of them with messages in order
+        auto produce = [&con](const char* prefix) {
+            for (int i = 0; i < 50; ++i)
+            {
+                con.msg(console::msg_log, (prefix + std::to_string(i)).c_str());
+            }
+        };
+
+        std::thread other(produce, "b");
+        produce("a");
+        other.join();
+        con.flush();
+
+        DOCTEST_CHECK(con.dropped() == 0);
+        DOCTEST_CHECK(target.m_msgs.size() == 100);
+
+        int next_a = 0, next_b = 0;
+        for (auto& m : target.m_msgs)
+        {
+            int& next = m[0] == 'a' ? next_a : next_b;
+            DOCTEST_CHECK(m.substr(1) == std::to_string(next));
+            next = std::stoi(m.substr(1)) + 1;
+        }
+
+        // asserts are written, by the background thread, before they return
+        con.msg(console::msg_info, "before assert");
+        con.msg(console::msg_assert, "assert");
+        DOCTEST_CHECK(target.m_msgs.back() == "assert");
+        DOCTEST_CHECK(target.m_msgs[target.m_msgs.size() - 2] == "before assert");
+        DOCTEST_CHECK(!target.m_from_caller);
+
+        con.msg(console::msg_info, "last");
+    }
+
+    // destroying the console writes the pending messages
+    DOCTEST_CHECK(target.m_msgs.back() == "last");
+}
+#endif
+
+DOCTEST_TEST_CASE("exception info")
+{
+    class info_handler : public exception_handler
+    {
+    public:
+        virtual void on_exception(const char* text) override
+        {
+            ++m_formatted;
+        }
+
+        virtual void on_engine_error(const char* error) override {}
+
+        virtual void on_exception_info(const exception_info& info) override
+        {
+            m_message = info.message();
+            m_resource = info.resource();
+            m_line = info.line();
+            m_frames = info.frames();
+        }
+
+        int m_formatted = 0;
+        std::string m_message, m_resource;
+        int m_line = 0;
+        std::vector<stack_frame> m_frames;
+    } handler;
+
+    // node's isolate only captures the stack when the depth is set
+    set_exception_stack_depth(10);
+    set_exception_handler(&handler);
+    run_script(
+        "function inner() { throw new Error('deep'); }\n"
+        "function outer() { inner(); }\n"
+        "outer();\n"
+        , "exception_info.js");
+    set_exception_handler(test_handler);
+
+    // the text is not formatted for handlers which don't ask for it
+    DOCTEST_CHECK(handler.m_formatted == 0);
+    DOCTEST_CHECK(handler.m_message.find("deep") != std::string::npos);
+#if !defined(JSBIND_JSC)
+    DOCTEST_CHECK(handler.m_resource == "exception_info.js");
+#endif
+    DOCTEST_CHECK(handler.m_line == 1);
+
+#if defined(JSBIND_V8) || defined(JSBIND_JSC)
+    DOCTEST_REQUIRE(handler.m_frames.size() >= 3);
+    DOCTEST_CHECK(handler.m_frames[0].function == "inner");
+    DOCTEST_CHECK(handler.m_frames[0].line == 1);
+    DOCTEST_CHECK(handler.m_frames[1].function == "outer");
+    DOCTEST_CHECK(handler.m_frames[1].line == 2);
+#endif
+
+    set_exception_stack_depth(1);
+    set_exception_handler(&handler);
+    run_script("function thrower() { throw new Error('shallow'); }\nthrower();\n", "exception_info.js");
+    set_exception_handler(test_handler);
+    set_exception_stack_depth(10);
+
+#if defined(JSBIND_V8) || defined(JSBIND_JSC)
+    DOCTEST_CHECK(handler.m_frames.size() == 1);
+#endif
+}
+
+DOCTEST_TEST_CASE("exception throttle")
+{
+    class recording_handler : public exception_handler
+    {
+    public:
+        virtual void on_exception(const char* text) override
+        {
+            m_texts.push_back(text);
+        }
+
+        virtual void on_engine_error(const char* error) override {}
+
+        std::vector<std::string> m_texts;
+    } target;
+
+    exception_throttle_config config;
+    config.dedup_window_seconds = 100;
+    config.reports_per_second = 0; // no refill, so that only the burst passes
+    config.burst = 3;
+    config.summary_interval_seconds = 100;
+
+    throttled_exception_handler handler(target, config);
+    set_exception_handler(&handler);
+
+    scope s;
+    run_script("throwSame = function() { throw new Error('same'); }; throwOther = function(i) { throw new Error('other' + i); };", "throttle.js");
+    auto same = local::global("throwSame");
+    auto other = local::global("throwOther");
+
+    for (int i = 0; i < 10; ++i)
+    {
+        same();
+    }
+
+    // repeats are collapsed
+    DOCTEST_CHECK(target.m_texts.size() == 1);
+    DOCTEST_CHECK(handler.suppressed() == 9);
+
+    // two tokens are left
+    for (int i = 0; i < 5; ++i)
+    {
+        other(i);
+    }
+
+    DOCTEST_CHECK(target.m_texts.size() == 3);
+    DOCTEST_CHECK(handler.suppressed() == 12);
+
+    handler.flush_summary();
+    set_exception_handler(test_handler);
+
+    DOCTEST_REQUIRE(target.m_texts.size() == 5);
+    DOCTEST_CHECK(target.m_texts[3].find("jsbind: 9 more of: ") == 0);
+    DOCTEST_CHECK(target.m_texts[3].find("same") != std::string::npos);
+    DOCTEST_CHECK(target.m_texts[4] == "jsbind: 3 more exceptions over the rate limit");
+
+    // the counts start over after a summary
+    handler.flush_summary();
+    DOCTEST_CHECK(target.m_texts.size() == 5);
+}
+
+#if !defined(JSBIND_EMSCRIPTEN)
+DOCTEST_TEST_CASE("watchdog")
+{
+    scope s;
+    watchdog wd(std::chrono::milliseconds(50), std::chrono::milliseconds(20));
+    set_watchdog(&wd);
+
+    run_script("watched = 1;", "watchdog");
+    DOCTEST_CHECK(local::global("watched").as<int>() == 1);
+    DOCTEST_CHECK(wd.timeouts() == 0);
+
+#if defined(JSBIND_V8)
+    // runaway scripts and calls are terminated and the engine can be used afterwards
+    run_script("for (;;) {}", "watchdog");
+    DOCTEST_CHECK(wd.timeouts() == 1);
+    DOCTEST_CHECK(test_handler->get_num_caught() == 1);
+
+    run_script("watched = 2; spin = function () { for (;;) {} };", "watchdog");
+    DOCTEST_CHECK(local::global("watched").as<int>() == 2);
+
+    auto spin = local::global("spin");
+    local ret = spin();
+    DOCTEST_CHECK(ret.isUndefined());
+    DOCTEST_CHECK(wd.timeouts() == 2);
+    DOCTEST_CHECK(test_handler->get_num_caught() == 1);
+
+    run_script("watched = 3;", "watchdog");
+    DOCTEST_CHECK(local::global("watched").as<int>() == 3);
+    DOCTEST_CHECK(wd.timeouts() == 2);
+#endif
+
+    set_watchdog(nullptr);
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+}
+#endif
+
+#if !defined(JSBIND_EMSCRIPTEN)
+DOCTEST_TEST_CASE("post")
+{
+    scope s;
+    run_script("posted = [];", "post");
+    auto before = get_post_queue_stats(true);
+
+    std::thread producer([]() {
+        for (int i = 0; i < 100; ++i)
+        {
+            post([i]() { local::global("posted").call<void>("push", i); });
+        }
+    });
+    producer.join();
+
+    DOCTEST_CHECK(get_post_queue_stats().depth == 100);
+    DOCTEST_CHECK(run_posted_tasks(40) == 40);
+    DOCTEST_CHECK(run_posted_tasks() == 60);
+
+    auto posted = local::global("posted");
+    DOCTEST_CHECK(posted["length"].as<int>() == 100);
+    DOCTEST_CHECK(posted[99].as<int>() == 99);
+
+    // results are sent back through futures
+    std::future<int> length;
+    std::atomic<bool> done(false);
+    std::thread asker([&]() {
+        length = post_with_result<int>([]() { return local::global("posted")["length"].as<int>(); });
+        length.wait();
+        post_with_result<void>([]() { run_script("posted = null;"); }).wait();
+        done = true;
+    });
+
+    while (!done)
+    {
+        run_posted_tasks();
+        std::this_thread::yield();
+    }
+    asker.join();
+
+    DOCTEST_CHECK(length.get() == 100);
+    DOCTEST_CHECK(local::global("posted").isNull());
+
+    auto stats = get_post_queue_stats();
+    DOCTEST_CHECK(stats.depth == 0);
+    DOCTEST_CHECK(stats.posted - before.posted == 102);
+    DOCTEST_CHECK(stats.wait_us.count == 102);
+
+    // exceptions go to the future, or to the exception handler, and the tasks after them still run
+    auto failed = post_with_result<int>([]() -> int { throw std::runtime_error("failed"); });
+    post([]() { throw std::runtime_error("lost"); });
+    bool ran = false;
+    post([&ran]() { ran = true; });
+
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+    DOCTEST_CHECK(run_posted_tasks() == 3);
+    DOCTEST_CHECK(ran);
+    DOCTEST_CHECK(test_handler->get_num_caught() == 1);
+    DOCTEST_CHECK_THROWS_AS(failed.get(), std::runtime_error);
+}
+#endif
+
+#if !defined(JSBIND_EMSCRIPTEN)
+DOCTEST_TEST_CASE("shared ring")
+{
+    scope s;
+    shared_ring ring(64);
+
+    auto obj = ring.to_local();
+    local::global().set("ring", obj);
+    run_script("ringSum = 0; ringCount = 0; function ringAdd(b) { ringSum += b[0] + b[b.length - 1]; ++ringCount; }", "shared ring");
+
+    // too big to ever fit
+    std::vector<uint8_t> big(61);
+    DOCTEST_CHECK(!ring.try_push(big.data(), uint32_t(big.size())));
+    DOCTEST_CHECK(ring.dropped() == 1);
+
+    // the producer wraps around many times while js drains, retrying the pushes which find the ring full
+    std::atomic<bool> done(false);
+    std::thread producer([&ring, &done]() {
+        for (uint8_t i = 1; i <= 200; ++i)
+        {
+            uint8_t rec[] = { i, 0, 0, 0, 0, i };
+            while (!ring.try_push(rec, 1 + i % 6)) std::this_thread::yield();
+        }
+        done = true;
+    });
+    while (!done || ring.used())
+    {
+        run_script("ring.drain(ringAdd);");
+    }
+    producer.join();
+
+    DOCTEST_CHECK(local::global("ringCount").as<int>() == 200);
+    int expected = 0;
+    for (int i = 1; i <= 200; ++i) expected += i + (i % 6 == 0 || i % 6 == 5 ? i : 0);
+    DOCTEST_CHECK(local::global("ringSum").as<int>() == expected);
+
+    // notification
+    run_script("ringReady = 0; ring.onready = function () { ++ringReady; do { ring.drain(ringAdd); } while (!ring.arm()); };");
+    DOCTEST_CHECK(local::global("ring").call<bool>("arm"));
+    uint8_t rec[] = { 1, 2 };
+    std::thread([&ring, &rec]() {
+        ring.try_push(rec, 2);
+        ring.try_push(rec, 2);
+    }).join();
+    run_posted_tasks();
+    DOCTEST_CHECK(local::global("ringReady").as<int>() == 1);
+    DOCTEST_CHECK(local::global("ringCount").as<int>() == 202);
+
+    DOCTEST_CHECK(local::global("ring").call<local>("pop").isNull());
+    run_script("ring = null;");
+}
+#endif
+
+#if defined(JSBIND_JSC)
+DOCTEST_TEST_CASE("contexts")
+{
+    scope s;
+    run_script("contextName = 'main';", "contexts");
+
+    {
+        jsbind::context other;
+        context_scope cs(other);
+
+        // a separate global object with its own bindings
+        DOCTEST_CHECK(local::global("contextName").isUndefined());
+        run_script("contextName = 'other'; otherClass = Module.Person.getClassName();", "contexts");
+        DOCTEST_CHECK(local::global("otherClass").as<std::string>() == jsbind::test::person::get_class_name());
+        DOCTEST_CHECK(local::global("Module")["getStoredVec"].typeOf().as<std::string>() == "function");
+    }
+
+    DOCTEST_CHECK(local::global("contextName").as<std::string>() == "main");
+    DOCTEST_CHECK(local::global("otherClass").isUndefined());
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+}
+#endif
+
+DOCTEST_TEST_CASE("ticket lock")
+{
+    jsbind::internal::ticket_lock lock;
+    std::vector<int> order;
+
+    lock.lock();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; ++i)
+    {
+        // each thread takes its ticket before the next one starts
+        threads.emplace_back([&lock, &order, i]() {
+            lock.lock();
+            order.push_back(i);
+            lock.unlock();
+        });
+        while (lock.queue_length() != uint32_t(i + 2)) std::this_thread::yield();
+    }
+    lock.unlock();
+
+    for (auto& t : threads) t.join();
+    DOCTEST_CHECK(order == std::vector<int>({ 0, 1, 2 }));
+    DOCTEST_CHECK(lock.queue_length() == 0);
+}
+
+#if defined(JSBIND_V8) && !defined(JSBIND_NODE)
+DOCTEST_TEST_CASE("context lock")
+{
+    auto before = get_context_lock_stats();
+
+    // nested in the context of the test runner, so there's no locking
+    enter_context();
+    exit_context();
+    DOCTEST_CHECK(get_context_lock_stats().acquisitions == before.acquisitions);
+
+    set_fair_context_lock(true);
+    exit_context(); // lets the threads have the isolate
+
+    std::atomic<int> sum(0);
+    auto worker = [&sum]() {
+        for (int i = 0; i < 10; ++i)
+        {
+            enter_context();
+            {
+                scope s;
+                sum += local::global("Math").call<int>("abs", -1);
+            }
+            exit_context();
+        }
+    };
+    std::thread a(worker), b(worker);
+    a.join();
+    b.join();
+
+    enter_context();
+    set_fair_context_lock(false);
+
+    DOCTEST_CHECK(sum == 20);
+
+    auto after = get_context_lock_stats();
+    DOCTEST_CHECK(after.acquisitions - before.acquisitions == 21);
+    DOCTEST_CHECK(after.wait_ns.count - before.wait_ns.count == 21);
+    DOCTEST_CHECK(after.hold_ns.count - before.hold_ns.count == 21);
+    DOCTEST_CHECK(after.contended <= after.acquisitions);
+}
+#endif
+
 DOCTEST_TEST_CASE("bind_static")
 {
     using jsbind::test::person;
@@ -627,6 +1098,39 @@ DOCTEST_TEST_CASE("bind_pod")
     DOCTEST_CHECK(s.age == 15);
 }
 
+DOCTEST_TEST_CASE("binding stats")
+{
+    reset_binding_stats();
+
+    run_script(
+        "for (var i = 0; i < 10; ++i) Module.storeVec(Module.getStoredVec());"
+        );
+
+    auto stats = binding_stats();
+#if defined(JSBIND_BINDING_STATS)
+    DOCTEST_CHECK(stats.size() == 2);
+    for (auto& stat : stats)
+    {
+        DOCTEST_CHECK((stat.name == "storeVec" || stat.name == "getStoredVec"));
+        DOCTEST_CHECK(stat.calls == 10);
+        DOCTEST_CHECK(stat.latency_ns.count == 10);
+    }
+
+    // the counters of a reset count as zero before their thread clears them
+    reset_binding_stats();
+    DOCTEST_CHECK(binding_stats().empty());
+    run_script("Module.storeVec(Module.getStoredVec());");
+    DOCTEST_CHECK(binding_stats().size() == 2);
+    DOCTEST_CHECK(binding_stats()[0].calls == 1);
+
+    // registering again, as after reinitialization, keeps one entry per binding
+    auto id = internal::register_binding("test.registered");
+    DOCTEST_CHECK(internal::register_binding("test.registered") == id);
+#else
+    DOCTEST_CHECK(stats.empty());
+#endif
+}
+
 }
 
 DOCTEST_TEST_SUITE("shared memory extension")
@@ -664,6 +1168,527 @@ DOCTEST_TEST_CASE("creation")
     DOCTEST_CHECK(moved.get_buffer() == data);
 }
 
+DOCTEST_TEST_CASE("shared ownership")
+{
+    scope s;
+
+    uint8_array ar(8);
+    auto store = ar.get_backing_store();
+
+    uint8_array view(store);
+    DOCTEST_CHECK(view.get_buffer() == ar.get_buffer());
+
+    ar.get_buffer()[3] = 42;
+    local jsview = view.get_persistent().to_local();
+    DOCTEST_CHECK(jsview[3].as<int32_t>() == 42);
+
+#if defined(JSBIND_V8)
+    local jsar = ar.get_persistent().to_local();
+#endif
+    auto moved = ar.transfer();
+    DOCTEST_CHECK(!ar.get_backing_store());
+    DOCTEST_CHECK(ar.get_persistent().is_empty());
+    DOCTEST_CHECK(moved.get_backing_store() == store);
+    DOCTEST_CHECK(moved.get_persistent().to_local()[3].as<int32_t>() == 42);
+
+#if defined(JSBIND_V8)
+    // the old js object is detached
+    DOCTEST_CHECK(jsar["length"].as<int32_t>() == 0);
+#endif
+
+    // transferring an empty buffer gives an empty buffer
+    auto empty = ar.transfer();
+    DOCTEST_CHECK(!empty.get_backing_store());
+    DOCTEST_CHECK(empty.get_buffer() == nullptr);
+    DOCTEST_CHECK(empty.get_size() == 0);
+
+    bool detached = view.detach();
+#if defined(JSBIND_V8) || defined(JSBIND_CEF)
+    DOCTEST_CHECK(detached);
+    DOCTEST_CHECK(view.get_persistent().is_empty());
+#else
+    // the backend can't detach, so the js object keeps the memory
+    DOCTEST_CHECK(!detached);
+    DOCTEST_CHECK(view.get_persistent().to_local()["length"].as<int32_t>() == 8);
+#endif
+    DOCTEST_CHECK(view.get_buffer()[3] == 42);
+}
+
+DOCTEST_TEST_CASE("mapped file")
+{
+    scope s;
+
+    const char* fname = "jsbind-mapped-test.bin";
+    {
+        auto f = fopen(fname, "wb");
+        const uint8_t contents[] = { 5, 4, 3, 2, 1 };
+        fwrite(contents, 1, sizeof(contents), f);
+        fclose(f);
+    }
+
+    {
+        auto m1 = mapped_array_buffer::open(fname, mapped_array_buffer::access_sequential);
+        DOCTEST_CHECK(m1.is_mapped());
+        DOCTEST_CHECK(m1.get_size() == 5);
+        DOCTEST_CHECK(m1.get_buffer()[1] == 4);
+
+        // opening again shares the mapping
+        auto m2 = mapped_array_buffer::open(fname);
+        DOCTEST_CHECK(m2.get_buffer() == m1.get_buffer());
+
+        local buf = m2.get_persistent().to_local();
+        DOCTEST_CHECK(buf["byteLength"].as<int32_t>() == 5);
+
+        // a private mapping has pages of its own
+        auto p = mapped_array_buffer::open_private(fname);
+        DOCTEST_CHECK(p.get_buffer() != m1.get_buffer());
+        p.get_buffer()[1] = 40;
+        DOCTEST_CHECK(m1.get_buffer()[1] == 4);
+    }
+
+    auto missing = mapped_array_buffer::open("jsbind-no-such-file.bin");
+    DOCTEST_CHECK(!missing.is_mapped());
+    DOCTEST_CHECK(missing.get_size() == 0);
+
+    remove(fname);
+}
+
+DOCTEST_TEST_CASE("typed array")
+{
+    scope s;
+
+    std::vector<float> vec = { 1.5f, 2.5f, 3.5f };
+    typed_array<float> floats(std::move(vec));
+    DOCTEST_CHECK(floats.size() == 3);
+
+    local far(std::move(floats));
+    DOCTEST_CHECK(far.typeOf().as<std::string>() == "object");
+    DOCTEST_CHECK(far["length"].as<int32_t>() == 3);
+    DOCTEST_CHECK(far[0].as<float>() == 1.5f);
+    DOCTEST_CHECK(far[2].as<float>() == 3.5f);
+
+    std::unique_ptr<uint16_t[]> data(new uint16_t[4]);
+    for (int i = 0; i < 4; ++i)
+    {
+        data[i] = uint16_t(1000 * i);
+    }
+
+    local sar(typed_array<uint16_t>(std::move(data), 4));
+    DOCTEST_CHECK(sar["length"].as<int32_t>() == 4);
+    DOCTEST_CHECK(sar[3].as<int32_t>() == 3000);
+
+#if !defined(JSBIND_EMSCRIPTEN)
+    // returned from a bound function, js uses the storage of the vector itself
+    int live = test::get_num_live_float_buffers();
+    run_script("madeFloats = Module.makeFloats(4); madeFloats[1] = 42; madeLength = madeFloats.length;", "typed array");
+    DOCTEST_CHECK(local::global("madeLength").as<int32_t>() == 4);
+    DOCTEST_CHECK(test::get_num_live_float_buffers() == live + 1);
+    DOCTEST_CHECK(test::get_made_floats()[1] == 42);
+    DOCTEST_CHECK(test::get_made_floats()[3] == 3);
+
+    run_script("madeFloats = null;", "typed array");
+#if defined(JSBIND_V8)
+    // and the finalizer frees it once js is done with it
+    internal::isolate->LowMemoryNotification();
+    DOCTEST_CHECK(test::get_num_live_float_buffers() == live);
+#endif
+#endif
+
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+}
+
+#if !defined(JSBIND_EMSCRIPTEN) && !defined(JSBIND_CEF)
+DOCTEST_TEST_CASE("typed array view")
+{
+    scope s;
+
+    run_script("viewed = new Float32Array([1, 2, 3, 4]).subarray(1);", "typed array view");
+    auto viewed = local::global("viewed");
+
+    auto view = viewed.as<typed_array_view<float>>();
+    DOCTEST_CHECK(view.size() == 3);
+    DOCTEST_CHECK(view[0] == 2);
+
+    // writes go to the js array
+    view[2] = 10;
+    DOCTEST_CHECK(viewed[2].as<float>() == 10);
+
+    DOCTEST_CHECK(viewed.as<typed_array_view<int32_t>>().empty());
+    DOCTEST_CHECK(local::global("Math").as<typed_array_view<float>>().empty());
+
+    auto vec = vecFromJSArray<int>(viewed);
+    DOCTEST_CHECK(vec == std::vector<int>({ 2, 3, 10 }));
+}
+#endif
+
+#if !defined(JSBIND_EMSCRIPTEN)
+DOCTEST_TEST_CASE("struct array")
+{
+    scope s;
+
+    std::vector<test::vec> vecs = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+    struct_array<test::vec> sa(vecs);
+
+    local view = sa.get_persistent().to_local();
+    DOCTEST_CHECK(view["length"].as<int32_t>() == 3);
+
+    auto y = view["y"];
+    auto stride = y["stride"].as<int32_t>();
+    auto offset = y["offset"].as<int32_t>();
+    DOCTEST_CHECK(stride == 2);
+    DOCTEST_CHECK(offset == 1);
+    DOCTEST_CHECK(y["array"][offset + 2 * stride].as<float>() == 6);
+
+    vecs[1].y = 10;
+    DOCTEST_CHECK(y["array"][offset + stride].as<float>() == 10);
+
+    vecs.resize(10);
+    sa.reset(vecs);
+    view = sa.get_persistent().to_local();
+    DOCTEST_CHECK(view["length"].as<int32_t>() == 10);
+    DOCTEST_CHECK(view["x"]["array"][2 * stride].as<float>() == 5);
+}
+
+DOCTEST_TEST_CASE("packed array")
+{
+    scope s;
+
+    std::vector<test::vec> vecs = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+    packed_array<test::vec> ar(vecs);
+    local packed(ar);
+
+    DOCTEST_CHECK(packed["length"].as<int32_t>() == 3);
+    DOCTEST_CHECK(packed.call<local>("get", 2)["y"].as<float>() == 6);
+
+    auto objs = packed.call<local>("toArray");
+    DOCTEST_CHECK(objs[1]["x"].as<float>() == 3);
+
+    objs[0].set("x", 10);
+    auto encoded = packed_array<test::vec>::js_class().call<local>("encode", objs);
+    auto back = encoded.as<packed_array<test::vec>>().to_vector();
+    DOCTEST_CHECK(back.size() == 3);
+    DOCTEST_CHECK(back[0].x == 10);
+    DOCTEST_CHECK(back[2].y == 6);
+
+    // a view of the packed bytes
+    auto floats = local::global("eval")("new Float32Array([0, 7, 8, 9, 0])");
+    auto sub = floats.call<local>("subarray", 1, 3);
+    auto from_view = sub.as<packed_array<test::vec>>().to_vector();
+    DOCTEST_CHECK(from_view.size() == 1);
+    DOCTEST_CHECK(from_view[0].x == 7);
+    DOCTEST_CHECK(from_view[0].y == 8);
+
+    // anything else is an error
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+    auto bad = local(5).as<packed_array<test::vec>>();
+    DOCTEST_CHECK(bad.size() == 0);
+    DOCTEST_CHECK(test_handler->get_num_caught() == 1);
+}
+
+DOCTEST_TEST_CASE("serialization")
+{
+    scope s;
+
+    auto obj = local::global("eval")("({ a: 1.5, b: 'str', c: [true, null, { d: 'inner' }], e: new Float32Array([1, 2, 3]) })");
+    obj.set("self", obj);
+
+    auto bytes = serialize(obj);
+    DOCTEST_CHECK(!bytes.empty());
+
+    // a copy received from elsewhere
+    serialized_value copy(bytes.data());
+    auto clone = deserialize(copy);
+    DOCTEST_CHECK(clone["a"].as<double>() == 1.5);
+    DOCTEST_CHECK(clone["b"].as<std::string>() == "str");
+    DOCTEST_CHECK(clone["c"][0].isTrue());
+    DOCTEST_CHECK(clone["c"][1].isNull());
+    DOCTEST_CHECK(clone["c"][2]["d"].as<std::string>() == "inner");
+    DOCTEST_CHECK(clone["e"][2].as<float>() == 3);
+#if !defined(JSBIND_CEF)
+    DOCTEST_CHECK(!clone.strictlyEquals(obj));
+    DOCTEST_CHECK(clone["self"].strictlyEquals(clone));
+#endif
+
+    auto buf = local::global("eval")("new Uint8Array([7, 8, 9]).buffer");
+    auto transferred = serialize(buf, { buf });
+    auto moved = deserialize(transferred);
+    DOCTEST_CHECK(moved["byteLength"].as<int32_t>() == 3);
+#if defined(JSBIND_V8)
+    DOCTEST_CHECK(transferred.transferred().size() == 1);
+    DOCTEST_CHECK(buf["byteLength"].as<int32_t>() == 0);
+#endif
+}
+
+#if defined(JSBIND_CEF)
+DOCTEST_TEST_CASE("bridge codec")
+{
+    scope s;
+
+    // bytes of js values read as the browser process would, with no engine
+    auto args = local::global("eval")("(function (v) { return [v, { name: 'j\\u00fcrgen', age: 30, x: 'skipped' }, [1, 2, 3], v]; })({ x: 1.5, y: -2 })");
+    auto bytes = serialize(args);
+
+    internal::codec_reader r(bytes.data().data(), bytes.data().size());
+    uint32_t length = 0;
+    DOCTEST_CHECK(r.read_array(length));
+    DOCTEST_CHECK(length == 4);
+
+    test::vec v, ref;
+    test::sec person;
+    std::vector<int> ints;
+    DOCTEST_CHECK(internal::codec_read(r, v));
+    DOCTEST_CHECK(internal::codec_read(r, person));
+    DOCTEST_CHECK(internal::codec_read(r, ints));
+    DOCTEST_CHECK(internal::codec_read(r, ref)); // encoded as a reference to the first one
+    DOCTEST_CHECK(r.at_end());
+    DOCTEST_CHECK(!r.failed());
+
+    DOCTEST_CHECK(v.x == 1.5f);
+    DOCTEST_CHECK(v.y == -2);
+    DOCTEST_CHECK(person.name == "j\xc3\xbcrgen");
+    DOCTEST_CHECK(person.age == 30);
+    DOCTEST_CHECK(ints == std::vector<int>({ 1, 2, 3 }));
+    DOCTEST_CHECK(ref.x == 1.5f);
+
+    // values of another type are skipped
+    internal::codec_reader r2(bytes.data().data(), bytes.data().size());
+    std::vector<std::string> strs;
+    DOCTEST_CHECK(!internal::codec_read(r2, strs));
+    DOCTEST_CHECK(r2.at_end());
+    DOCTEST_CHECK(!r2.failed());
+
+    // and back
+    internal::codec_writer w;
+    w.write_array(2);
+    internal::codec_write(w, person);
+    internal::codec_write(w, std::string("done"));
+    auto back = deserialize(serialized_value(w.data()));
+    DOCTEST_CHECK(back[0]["name"].as<std::string>() == person.name);
+    DOCTEST_CHECK(back[0]["age"].as<int>() == 30);
+    DOCTEST_CHECK(back[1].as<std::string>() == "done");
+
+    DOCTEST_CHECK(test_handler->get_num_caught() == 0);
+}
+#endif
+#endif
+
+}
+
+DOCTEST_TEST_SUITE("gc")
+{
+
+DOCTEST_TEST_CASE("histogram")
+{
+    histogram h;
+    h.record(0);
+    h.record(3);
+    h.record(100);
+    h.record(1000);
+
+    auto snap = h.get();
+    DOCTEST_CHECK(snap.count == 4);
+    DOCTEST_CHECK(snap.sum == 1103);
+    DOCTEST_CHECK(snap.max == 1000);
+    DOCTEST_CHECK(snap.buckets[0] == 1);
+    DOCTEST_CHECK(snap.buckets[2] == 1);
+    DOCTEST_CHECK(snap.percentile(0) == 0);
+    DOCTEST_CHECK(snap.percentile(0.5) == 3);
+    DOCTEST_CHECK(snap.percentile(1) == 1000);
+
+    auto rolled = h.roll();
+    DOCTEST_CHECK(rolled.count == 4);
+    DOCTEST_CHECK(h.get().count == 0);
+}
+
+DOCTEST_TEST_CASE("events")
+{
+    scope s;
+
+    struct counter : public gc_observer
+    {
+        virtual void on_gc(const gc_event& e) override
+        {
+            ++count;
+            if (e.type == gc_scavenge && e.bytes_freed > 0) ++freeing_scavenges;
+        }
+        int count = 0;
+        int freeing_scavenges = 0;
+    } c;
+    set_gc_observer(&c);
+
+    run_script("var garbage; for (var i = 0; i < 200000; ++i) garbage = { i: i, a: [i, i] };", "gc-test");
+
+    set_gc_observer(nullptr);
+
+    auto heap = get_heap_stats();
+#if defined(JSBIND_V8)
+    DOCTEST_CHECK(c.count > 0);
+    DOCTEST_CHECK(get_gc_stats().pauses_us[gc_scavenge].count > 0);
+    DOCTEST_CHECK(c.freeing_scavenges > 0); // the garbage is measured by every collection
+    DOCTEST_CHECK(heap.used_heap_size > 0);
+    DOCTEST_CHECK(heap.used_heap_size <= heap.total_heap_size);
+#else
+    DOCTEST_CHECK(heap.used_heap_size == 0);
+#endif
+}
+
+DOCTEST_TEST_CASE("heap limits")
+{
+    scope s;
+
+    struct soft_handler : public heap_limit_handler
+    {
+        virtual action on_near_heap_limit(size_t) override { return terminate; }
+        virtual void on_soft_limit(size_t used) override { ++count; last_used = used; }
+        int count = 0;
+        size_t last_used = 0;
+    } handler;
+    set_heap_limit_handler(&handler);
+
+    auto limits = get_heap_limits();
+    auto soft = limits;
+    soft.soft_limit = 1; // always above it
+    set_heap_limits(soft);
+    DOCTEST_CHECK(get_heap_limits().soft_limit == 1);
+
+    // the soft limit is checked after full collections, which need a growing old generation
+    run_script("var kept = []; for (var i = 0; i < 1000000; ++i) kept.push({ i: i, a: [i, i] }); kept = null;", "gc-test");
+
+#if defined(JSBIND_V8)
+    // called once when crossing the limit, not after every collection
+    DOCTEST_CHECK(handler.count == 1);
+    DOCTEST_CHECK(handler.last_used > 1);
+#else
+    DOCTEST_CHECK(handler.count == 0);
+#endif
+
+    set_heap_limits(limits);
+    set_heap_limit_handler(nullptr);
+}
+
+#if defined(JSBIND_V8)
+DOCTEST_TEST_CASE("near heap limit")
+{
+    struct near_handler : public heap_limit_handler
+    {
+        // shedding frees nothing here, so the raised limit must run out and terminate the js
+        virtual action on_near_heap_limit(size_t limit) override { ++count; last_limit = limit; return shed; }
+        int count = 0;
+        size_t last_limit = 0;
+    } handler;
+
+    // the heap of the test runner is too big to be filled, so a child isolate with a small one stands in for it
+    auto allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+    v8::Isolate::CreateParams params;
+    params.array_buffer_allocator = allocator;
+    params.constraints.set_max_old_space_size(16);
+    auto main_isolate = internal::isolate;
+#if defined(JSBIND_NODE)
+    // node's platform has to know of the isolate before it's initialized
+    auto platform = node::GetMainThreadMultiIsolatePlatform();
+    auto child = v8::Isolate::Allocate();
+    platform->RegisterIsolate(child, node::GetCurrentEventLoop(main_isolate));
+    v8::Isolate::Initialize(child, params);
+#else
+    auto child = v8::Isolate::New(params);
+#endif
+
+    internal::isolate = child;
+    {
+        v8::Locker locker(child);
+        v8::Isolate::Scope isolate_scope(child);
+        v8::HandleScope handle_scope(child);
+        auto context = v8::Context::New(child);
+        v8::Context::Scope context_scope(context);
+
+        set_heap_limit_handler(&handler);
+
+        v8::TryCatch try_catch(child);
+        auto src = v8::String::NewFromUtf8(child, "var a = []; for (;;) a.push([1, 2, 3, 4]);", v8::NewStringType::kNormal).ToLocalChecked();
+        auto script = v8::Script::Compile(context, src).ToLocalChecked();
+        DOCTEST_CHECK(script->Run(context).IsEmpty());
+        DOCTEST_CHECK(try_catch.HasTerminated());
+
+        set_heap_limit_handler(nullptr);
+    }
+    internal::isolate = main_isolate;
+
+#if defined(JSBIND_NODE)
+    platform->UnregisterIsolate(child);
+#endif
+    child->Dispose();
+    delete allocator;
+
+    DOCTEST_CHECK(handler.count == 1);
+    DOCTEST_CHECK(handler.last_limit > 0);
+    DOCTEST_CHECK(test_handler->get_num_caught() >= 1); // the terminations
+}
+#endif
+
+DOCTEST_TEST_CASE("profiler")
+{
+    scope s;
+
+    bool started = profiler::start("test", 100);
+#if defined(JSBIND_V8)
+    DOCTEST_CHECK(started);
+    DOCTEST_CHECK(profiler::is_running());
+    DOCTEST_CHECK(!profiler::start("second"));
+
+    run_script("for (var i = 0; i < 20000; ++i) Module.storeVec(Module.getStoredVec());", "profiled");
+
+    auto json = profiler::stop();
+    DOCTEST_CHECK(!profiler::is_running());
+
+    auto profile = local::global("JSON").call<local>("parse", json);
+    DOCTEST_CHECK(profile["nodes"]["length"].as<int32_t>() > 0);
+    DOCTEST_CHECK(profile["samples"]["length"].as<int32_t>() == profile["timeDeltas"]["length"].as<int32_t>());
+    DOCTEST_CHECK(json.find("\"storeVec\"") != std::string::npos);
+    // bound later with the same signature, but never called
+    DOCTEST_CHECK(json.find("\"storeVecCopy\"") == std::string::npos);
+#else
+    DOCTEST_CHECK(!started);
+    DOCTEST_CHECK(profiler::stop().empty());
+#endif
+}
+
+DOCTEST_TEST_CASE("heap snapshot")
+{
+    scope s;
+
+    auto before = take_heap_summary();
+    run_script("function Leaky() { this.payload = [1, 2, 3]; } var leaks = []; for (var i = 0; i < 1000; ++i) leaks.push(new Leaky());", "leak");
+    auto after = take_heap_summary();
+
+    auto growth = diff_heap_summaries(before, after, 1000);
+#if defined(JSBIND_V8)
+    auto leaky = std::find_if(growth.begin(), growth.end(), [](const heap_growth& g) { return g.constructor == "Leaky"; });
+    DOCTEST_CHECK(leaky != growth.end());
+    DOCTEST_CHECK(leaky->count == 1000);
+    DOCTEST_CHECK(!leaky->retainers.empty());
+
+    // the constructor itself is apart from its instances
+    auto closure = std::find_if(growth.begin(), growth.end(), [](const heap_growth& g) { return g.constructor == "(closure) Leaky"; });
+    DOCTEST_CHECK(closure != growth.end());
+    DOCTEST_CHECK(closure->count == 1);
+
+    const char* fname = "jsbind-test.heapsnapshot";
+    DOCTEST_CHECK(write_heap_snapshot(fname));
+    auto f = fopen(fname, "rb");
+    DOCTEST_CHECK(f);
+    char start[12] = {};
+    fread(start, 1, 11, f);
+    fclose(f);
+    DOCTEST_CHECK(std::string(start) == "{\"snapshot\"");
+    remove(fname);
+#else
+    DOCTEST_CHECK(growth.empty());
+    DOCTEST_CHECK(!write_heap_snapshot("jsbind-test.heapsnapshot"));
+#endif
+
+    run_script("leaks = null;");
+}
+
 }
 
 namespace jsbind